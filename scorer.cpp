@@ -7,9 +7,9 @@
 // Date Last Modified--+ 8/20/2025
 // Description---------+ Controls four 7-segment displays used to display scores
 // --------------------- for 2 players (2 button inputs) (7 segs are comm. Anode)
-// Features------------+ Score incrementing, winning conditions (up to 21 win by
-// --------------------- 2, score flashing when winning conditions are met, game
-// --------------------- reset with 3 sec button hold
+// Features------------+ Score incrementing, winning conditions (RULESETS, up to
+// --------------------- 21 win by 2 by default), score flashing when winning
+// --------------------- conditions are met, game reset with 3 sec button hold
 
 /*===================================================================*\   
 |                             BOARD LEVEL                             |
@@ -18,7 +18,7 @@
 // Board---------------+ Arduino Mega or Mega 2560
 // Processor-----------+ ATmega2560 (Mega 2560)
 // Programmer----------+ AVRISP mkll
-// Output Pins---------+ 2-8, 11, 14-20, 22-35
+// Output Pins---------+ 2-8, 14-20, 22-35
 // Input Pins----------+ 9-10                                         
                                                                      /*
      7 seg display          7 Seg Common Anode Output
@@ -30,7 +30,7 @@
       +--------+            4: 1, 0, 0, 1, 1, 0, 0   0x98
       |        |            5: 0, 1, 0, 0, 1, 0, 0   0x48
     E |        | C          6: 0, 1, 0, 0, 0, 0, 0   0x40
-      +--------+            7: 0, 0, 0, 1, 1, 1, 1   0x1D
+      +--------+            7: 0, 0, 0, 1, 1, 1, 1   0x1E
           D                 8: 0, 0, 0, 0, 0, 0, 0   0x0
                             9: 0, 0, 0, 0, 1, 0, 0   0x8
 
@@ -43,19 +43,181 @@
 #define P2_BUTTON 9          // Player 2 Button Input Pin
 
 // Reset
-#define RESET 11             // Pin tied to RESET
+// #define WATCHDOG_RESET    // Longer hold reboots the board via the watchdog
+#define HARD_RESET_HOLD_MS 10000 // Button hold threshold to reboot the board
+
+// Players
+#define NUM_PLAYERS 2        // Players, 1 button & score each (max 8)
+#define SCORE_DIGITS 2       // Digits of the widest player score
 
 // Game Configuration
 #define BUTTON_HOLD_MS 3000      // Button hold threshold to reset game
 #define SCORE_BLINK_MS 500       // Length of time between winning score blinks
-#define BUTTON_PRESS_LENGTH 200  // Approx. length of time of a button press
-#define UP_TO_SCORE 21           // Score to play up to
+#define FULL_REFRESH_MS 1000     // Period of forced full display refresh
+
+// Game Resume
+#define RESUME_GAME              // Keep the game in .noinit RAM across resets
+#define SAVED_GAME_MAGIC 0x5C0E  // Marks RAM holding a saved game
+
+// Score Journal
+// #define SCORE_JOURNAL         // Journal score changes to EEPROM (power cuts)
+#define JOURNAL_EEPROM_START 16  // First EEPROM byte of the journal (after settings)
+#define JOURNAL_QUEUE_SIZE 16    // Records waiting on the EEPROM (power of 2)
+
+// Match Play
+#define GAME_OVER_MS 5000        // Winning score blinks this long between games
+#define STANDINGS_MS 2000        // Games won shown this long before next game
+
+// Rulesets (index into RULESETS)
+#define RULES_CLASSIC 0          // Up to 21, win by 2, single game
+#define RULES_PICKLEBALL 1       // Up to 11, win by 2, best of 3
+#define RULES_TABLE_TENNIS 2     // Up to 11, win by 2, best of 5
+#define RULES_RALLY_15 3         // Up to 15, win by 2, best of 3
+#define RULES_VOLLEYBALL 4       // Up to 25, win by 2, best of 5
+#define RULES_BADMINTON 5        // Up to 21, win by 2 capped at 30, best of 3
+#define RULESET RULES_CLASSIC    // Ruleset played (default if from EEPROM)
+// #define RULES_FROM_EEPROM     // Read the ruleset index from EEPROM at boot
+#define RULES_EEPROM_ADDR 0      // EEPROM byte holding the ruleset index
+
+// Button Debounce
+#define DEBOUNCE_SAMPLE_MS 1     // Time between button samples
+#define DEBOUNCE_SAMPLES 10      // Agreeing samples to accept a button level
+
+// Button Capture
+#ifndef BUTTON_CAPTURE_IRQ
+#define BUTTON_CAPTURE_IRQ 1     // Capture button edges from interrupts (0 = sampled)
+#endif
+#define DEBOUNCE_LOCKOUT_MS 20   // New level must hold this long to be accepted
+#define EDGE_RING_SIZE 16        // Captured edge buffer size (power of 2)
 
 // 7 Segment Configuration
 #define SEVEN_SEGMENTS 7     // # of segments used
 #define NUM_DIGITS 10        // # of digits per display
 #define COMMON_ANODE         // Define Common Anode as 7 Segment Type
 
+// Display Driver
+#define DISPLAY_DIGITAL_WRITE 0  // Reference driver: 1 digitalWrite per segment
+#define DISPLAY_DIRECT_PORT 1    // Masked writes straight to PORTx registers
+#ifndef DISPLAY_DRIVER
+#define DISPLAY_DRIVER DISPLAY_DIRECT_PORT
+#endif
+
+// Display Backend
+#define DISPLAY_STATIC 0         // Dedicated segment pins per digit
+#define DISPLAY_MULTIPLEX 1      // Shared segment bus, 1 enable pin per digit
+#define DISPLAY_SHIFT_595 2      // 74HC595 chain on hardware SPI
+#define DISPLAY_MAX7219 3        // MAX7219 display controller on hardware SPI
+#ifndef DISPLAY_BACKEND
+#define DISPLAY_BACKEND DISPLAY_STATIC
+#endif
+
+// Display Refresh
+#ifndef DISPLAY_REFRESH_ISR
+#define DISPLAY_REFRESH_ISR 1    // Drive segment outputs from a Timer1 ISR (0 = loop)
+#endif
+#define DISPLAY_REFRESH_HZ 500   // Timer1 refresh rate (DISPLAY_STATIC)
+#define FRAME_DIGITS 4           // Digits per frame, every player's in order
+
+// Multiplexing (DISPLAY_MULTIPLEX)
+#define MUX_SCAN_HZ 200          // Full scans of all digits per second
+#define MUX_ENABLE_ON HIGH       // Digit enable level when lit
+#define MUX_ENABLE_OFF LOW       // Digit enable level when dark
+
+// Hardware SPI (DISPLAY_SHIFT_595, DISPLAY_MAX7219)
+#define SPI_MOSI_PIN 51          // SER of the first 595 / MAX7219 DIN
+#define SPI_SCK_PIN 52           // SRCLK of every 595 / MAX7219 CLK
+
+// Shift Registers (DISPLAY_SHIFT_595), QH = A -> QB = G, QA unused
+#define SHIFT_LATCH_PIN 53       // RCLK of every 595 (SPI SS, keeps master)
+
+// MAX7219 (DISPLAY_MAX7219), DIG0 -> DIG3 = frame digits, common cathode
+#define MAX7219_LOAD_PIN 53      // LOAD of the MAX7219 (SPI SS, keeps master)
+#define MAX7219_INTENSITY 8      // Segment current, 0 -> 15 (of 16/32 Iseg)
+
+// MAX7219 Registers
+#define MAX7219_DIGIT0 0x01       // Digit registers 0x01 -> 0x08
+#define MAX7219_DECODE_MODE 0x09  // 0 = raw segments on every digit
+#define MAX7219_INTENSITY_REG 0x0A
+#define MAX7219_SCAN_LIMIT 0x0B   // Last digit scanned
+#define MAX7219_SHUTDOWN 0x0C     // 1 = normal operation
+#define MAX7219_DISPLAY_TEST 0x0F // 0 = normal operation
+
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+#define TIMER1_HZ (MUX_SCAN_HZ * FRAME_DIGITS) // 1 digit per Timer1 tick
+#else
+#define TIMER1_HZ DISPLAY_REFRESH_HZ           // All digits per Timer1 tick
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX && !DISPLAY_REFRESH_ISR
+#error "DISPLAY_MULTIPLEX scans digits from the Timer1 refresh ISR"
+#endif
+
+// Instrumentation
+// #define LOOP_STATS            // Histogram of loop() pass intervals
+// #define LATENCY_TRACE         // Histogram of release -> segment latency
+#define HIST_BUCKETS 24          // log2 buckets, top bucket holds >= 8.4 s
+#define SERIAL_BAUD 115200       // Serial rate for stats dumps
+#define STATS_DUMP_CMD 's'       // Serial byte requesting a stats dump
+
+// Event Log
+// #define EVENT_LOG             // Binary log of game events in RAM
+#define EVENT_LOG_SIZE 2048      // Log ring size in bytes (power of 2)
+#define LOG_TICK_MS 4            // Resolution of event timestamps
+#define LOG_DUMP_CMD 'l'         // Serial byte requesting a log dump
+
+#if defined(LOOP_STATS) || defined(LATENCY_TRACE) || defined(EVENT_LOG)
+#define STATS_SERIAL             // Stats are dumped over Serial
+#endif
+
+#if BUTTON_CAPTURE_IRQ && !DISPLAY_REFRESH_ISR
+#error "BUTTON_CAPTURE_IRQ samples pins without pin-change IRQ from Timer1"
+#endif
+
+#if defined(RULES_FROM_EEPROM) || defined(SCORE_JOURNAL)
+#include <avr/eeprom.h>
+#endif
+
+#ifdef WATCHDOG_RESET
+#include <avr/wdt.h>
+#endif
+
+#ifdef RESUME_GAME
+#include <util/crc16.h>
+#endif
+
+// Journal Records, 1 byte each (lap bit + record code)
+#define JOURNAL_LAP 0x80         // Flips on each pass over the journal
+#define JOURNAL_CODE 0x7F        // Record code bits
+#define JOURNAL_SCORE(player, delta) ((player) << 3 | ((delta) & 0x07)) // 0x00 -> 0x3F
+#define JOURNAL_NEXT_GAME 0x40   // Next game of the match started
+#define JOURNAL_RESET 0x41       // Game & match reset
+#define JOURNAL_ERASED 0x7F      // Never written (erased EEPROM = 0xFF)
+#define JOURNAL_SLOTS (E2END + 1 - JOURNAL_EEPROM_START) // Records in the journal
+
+#if defined(SCORE_JOURNAL) && defined(RULES_FROM_EEPROM)
+static_assert(JOURNAL_EEPROM_START > RULES_EEPROM_ADDR, "journal overlaps settings");
+#endif
+
+/*
+ * Log events, 1 -> 3 bytes each. A header byte holds the type (bits 7:5),
+ * the player (bits 4:2) and how many bytes follow (bits 1:0). Those hold
+ * the LOG_TICK_MS ticks since the previous event, LSB first (none = 0)
+ */
+#define LOG_PRESS 0              // Button went down
+#define LOG_RELEASE 1            // Button went up
+#define LOG_HOLD 2               // Button held for BUTTON_HOLD_MS
+#define LOG_SCORE 3              // Player scored a point
+#define LOG_WIN 4                // Player won the game
+#define LOG_RESET 5              // Game & match reset
+#define LOG_NEXT_GAME 6          // Next game of the match started
+#define LOG_IDLE 7               // No event, pads out gaps over LOG_DT_MAX
+#define LOG_DT_MAX 0xFFFF        // Most ticks in 1 event (~262 s)
+#define LOG_HEADER(type, player, dt_bytes) ((type) << 5 | (player) << 2 | (dt_bytes))
+#define LOG_TYPE(header) ((header) >> 5)
+#define LOG_PLAYER(header) ((header) >> 2 & 0x07)
+#define LOG_DT_BYTES(header) ((header) & 0x03)
+#define LOG_SIZE(header) (1 + LOG_DT_BYTES(header))
+
 // Common Type
 #ifdef COMMON_ANODE     // Active low
 #define ON LOW
@@ -65,220 +227,1841 @@
 #define OFF LOW
 #endif
 
+// Packed Glyphs
+#define SEG_BIT(seg) (0x80 >> (seg))  // Glyph bit of segment (0 = A)
+#define GLYPH_BLANK 0x00              // No segments lit
+#ifdef COMMON_ANODE
+#define GLYPH_HIGH(glyph) ((uint8_t)~(glyph)) // Segments driven HIGH
+#else
+#define GLYPH_HIGH(glyph) (glyph)
+#endif
+
+/*===================================================================*\   
+|                               PIN MAP                               |
+\*===================================================================*/
+
+/*
+ * Mega 2560 digital pin -> output port & bit, resolved by the compiler.
+ * Ports use the core's numbering (PA = 1 -> PL = 12)
+*/
+#define PIN_MAP(port, bit) ((port) << 4 | (bit))
+constexpr uint8_t MEGA_PIN_MAP[] = {
+  PIN_MAP(PE, 0), PIN_MAP(PE, 1), PIN_MAP(PE, 4), PIN_MAP(PE, 5), PIN_MAP(PG, 5),
+  PIN_MAP(PE, 3), PIN_MAP(PH, 3), PIN_MAP(PH, 4), PIN_MAP(PH, 5), PIN_MAP(PH, 6),
+  PIN_MAP(PB, 4), PIN_MAP(PB, 5), PIN_MAP(PB, 6), PIN_MAP(PB, 7), PIN_MAP(PJ, 1),
+  PIN_MAP(PJ, 0), PIN_MAP(PH, 1), PIN_MAP(PH, 0), PIN_MAP(PD, 3), PIN_MAP(PD, 2),
+  PIN_MAP(PD, 1), PIN_MAP(PD, 0), PIN_MAP(PA, 0), PIN_MAP(PA, 1), PIN_MAP(PA, 2),
+  PIN_MAP(PA, 3), PIN_MAP(PA, 4), PIN_MAP(PA, 5), PIN_MAP(PA, 6), PIN_MAP(PA, 7),
+  PIN_MAP(PC, 7), PIN_MAP(PC, 6), PIN_MAP(PC, 5), PIN_MAP(PC, 4), PIN_MAP(PC, 3),
+  PIN_MAP(PC, 2), PIN_MAP(PC, 1), PIN_MAP(PC, 0), PIN_MAP(PD, 7), PIN_MAP(PG, 2),
+  PIN_MAP(PG, 1), PIN_MAP(PG, 0), PIN_MAP(PL, 7), PIN_MAP(PL, 6), PIN_MAP(PL, 5),
+  PIN_MAP(PL, 4), PIN_MAP(PL, 3), PIN_MAP(PL, 2), PIN_MAP(PL, 1), PIN_MAP(PL, 0),
+  PIN_MAP(PB, 3), PIN_MAP(PB, 2), PIN_MAP(PB, 1), PIN_MAP(PB, 0), PIN_MAP(PF, 0),
+  PIN_MAP(PF, 1), PIN_MAP(PF, 2), PIN_MAP(PF, 3), PIN_MAP(PF, 4), PIN_MAP(PF, 5),
+  PIN_MAP(PF, 6), PIN_MAP(PF, 7), PIN_MAP(PK, 0), PIN_MAP(PK, 1), PIN_MAP(PK, 2),
+  PIN_MAP(PK, 3), PIN_MAP(PK, 4), PIN_MAP(PK, 5), PIN_MAP(PK, 6), PIN_MAP(PK, 7)
+};
+
+constexpr uint8_t pinPort(uint8_t pin) { return MEGA_PIN_MAP[pin] >> 4; }
+constexpr uint8_t pinMask(uint8_t pin) { return 1 << (MEGA_PIN_MAP[pin] & 0x0F); }
+constexpr uint8_t pinMaskOn(uint8_t port, uint8_t pin) {
+  return pinPort(pin) == port ? pinMask(pin) : 0;
+}
+
+#ifdef __AVR__
+// Data space address of PORTx by core port number (PINx = -2, DDRx = -1)
+constexpr uint16_t MEGA_PORT_ADDR[] = {
+  0, 0x22, 0x25, 0x28, 0x2B, 0x2E, 0x31, 0x34, 0x102, 0, 0x105, 0x108, 0x10B
+};
+#define PORT_OUT(port) _SFR_MEM8(MEGA_PORT_ADDR[port])
+#define PORT_IN(port) _SFR_MEM8(MEGA_PORT_ADDR[port] - 2)
+#else
+#define PORT_OUT(port) (*portOutputRegister(port))
+#define PORT_IN(port) (*portInputRegister(port))
+#endif
+
 /*===================================================================*\   
 |                           TYPE DEFINITIONS                          |
 \*===================================================================*/
 
 /*
- * Player type keeps track of its pin assignments, score digit values,
- * button hold start time, and button states (current & previous)
+ * Debounced button events
+ */
+typedef enum{
+  BUTTON_NONE,    // No change
+  BUTTON_PRESS,   // Button went down
+  BUTTON_HOLD,    // Button held for BUTTON_HOLD_MS
+#ifdef WATCHDOG_RESET
+  BUTTON_LONG_HOLD, // Button held for HARD_RESET_HOLD_MS
+#endif
+  BUTTON_RELEASE  // Button went up
+} ButtonEvent;
+
+/*
+ * Button edge captured in interrupt context
+ */
+typedef struct{
+  unsigned long time; // millis() at capture
+  uint8_t button;     // Player index (0 = Player 1)
+  bool level;         // New raw level (HIGH = pressed)
+#ifdef LATENCY_TRACE
+  unsigned long us;   // micros() at capture
+#endif
+} ButtonEdge;
+
+/*
+ * Phases of the winning score blink, each lasting SCORE_BLINK_MS
+ */
+typedef enum{
+  BLINK_BLANK,  // Winning score is blanked
+  BLINK_SCORE   // Winning score is shown
+} BlinkPhase;
+
+/*
+ * Ruleset type describes how a game is won. A leader wins on reaching
+ * target with a lead of at least margin, or outright on reaching cap
+ */
+typedef struct{
+  uint16_t target; // Score to play up to
+  uint8_t margin;  // Lead needed to win at or past target (1 = none)
+  uint16_t cap;    // Score that wins regardless of margin (0 = no cap)
+  uint8_t games;   // Games per match (best of)
+} Ruleset;
+
+/*
+ * GameRecord type keeps the final score of one game of a match
+ */
+#if SCORE_DIGITS > 2
+typedef uint16_t HistoryScore;
+#else
+typedef uint8_t HistoryScore;  // 2 digit scores fit a byte
+#endif
+typedef struct{
+  HistoryScore score[NUM_PLAYERS]; // Final score per player
+} GameRecord;
+
+/*
+ * Histogram type counts microsecond durations in log2 buckets. Bucket
+ * b holds [2^b, 2^(b+1)), bucket 0 also holds 0
+ */
+typedef struct{
+  unsigned long count[HIST_BUCKETS]; // Samples per bucket
+  unsigned long n;                   // Total samples
+  unsigned long min;                 // Shortest sample
+  unsigned long max;                 // Longest sample
+} Histogram;
+
+/*
+ * FastPin type binds one output pin at compile time, writes fold into
+ * a single sbi/cbi (or a fixed-address read-modify-write above 0x5F)
+ */
+template<uint8_t PIN>
+struct FastPin{
+  static inline void write(uint8_t level){
+    if(level) PORT_OUT(pinPort(PIN)) |= pinMask(PIN);
+    else PORT_OUT(pinPort(PIN)) &= ~pinMask(PIN);
+  }
+};
+
+/*
+ * DigitSelect type binds the digit enable pins of a multiplexed display
+ * at compile time (first pin = frame digit 0)
+ */
+template<uint8_t... PINS> struct DigitSelect;
+
+template<>
+struct DigitSelect<>{
+  static const uint8_t COUNT = 0;
+  static inline void write(uint8_t, uint8_t){}
+  static uint8_t pin(uint8_t){ return 0xFF; }
+  static void begin(){}
+};
+
+template<uint8_t PIN, uint8_t... REST>
+struct DigitSelect<PIN, REST...>{
+  static const uint8_t COUNT = 1 + sizeof...(REST);
+
+  // Drives the enable pin of one digit
+  static inline void write(uint8_t digit, uint8_t level){
+    if(digit == 0) FastPin<PIN>::write(level);
+    else DigitSelect<REST...>::write(digit - 1, level);
+  }
+
+  // Enable pin number of a digit
+  static uint8_t pin(uint8_t digit){
+    return digit == 0 ? PIN : DigitSelect<REST...>::pin(digit - 1);
+  }
+
+  // Configures the enable pins as outputs, all digits dark
+  static void begin(){
+    pinMode(PIN, OUTPUT);
+    digitalWrite(PIN, MUX_ENABLE_OFF);
+    DigitSelect<REST...>::begin();
+  }
+};
+
+/*
+ * SegmentPins type binds the segment pins (A -> G) of one digit at
+ * compile time, so a write folds into one masked write per port used
+ */
+template<uint8_t SA, uint8_t SB, uint8_t SC, uint8_t SD, uint8_t SE,
+         uint8_t SF, uint8_t SG>
+struct SegmentPins{
+  // Bits of the digit on a port
+  static constexpr uint8_t mask(uint8_t port){
+    return pinMaskOn(port, SA) | pinMaskOn(port, SB) | pinMaskOn(port, SC) |
+           pinMaskOn(port, SD) | pinMaskOn(port, SE) | pinMaskOn(port, SF) |
+           pinMaskOn(port, SG);
+  }
+
+  // Bits of the digit on a port to drive HIGH
+  static inline uint8_t bits(uint8_t port, uint8_t high){
+    return ((high & SEG_BIT(0)) ? pinMaskOn(port, SA) : 0) |
+           ((high & SEG_BIT(1)) ? pinMaskOn(port, SB) : 0) |
+           ((high & SEG_BIT(2)) ? pinMaskOn(port, SC) : 0) |
+           ((high & SEG_BIT(3)) ? pinMaskOn(port, SD) : 0) |
+           ((high & SEG_BIT(4)) ? pinMaskOn(port, SE) : 0) |
+           ((high & SEG_BIT(5)) ? pinMaskOn(port, SF) : 0) |
+           ((high & SEG_BIT(6)) ? pinMaskOn(port, SG) : 0);
+  }
+
+  // Masked write of one port, compiled out if the digit has no pin on it
+  template<uint8_t PORT> static inline void writePort(uint8_t high){
+    if(mask(PORT)) PORT_OUT(PORT) = (PORT_OUT(PORT) & ~mask(PORT)) | bits(PORT, high);
+  }
+
+  // Pin number of a segment (0 = A)
+  static uint8_t pin(uint8_t seg){
+    static const uint8_t PINS[SEVEN_SEGMENTS] = {SA, SB, SC, SD, SE, SF, SG};
+    return PINS[seg];
+  }
+
+  // Configures the segment pins as outputs
+  static void begin(){
+    for(uint8_t i = 0; i < SEVEN_SEGMENTS; i++) pinMode(pin(i), OUTPUT);
+  }
+
+  // Displays a packed glyph
+  static void write(uint8_t glyph){
+    uint8_t high = GLYPH_HIGH(glyph);
+#if DISPLAY_DRIVER == DISPLAY_DIRECT_PORT
+    uint8_t sreg = SREG; // atomic, ports above 0x5F have no sbi/cbi
+    cli();
+    writePort<PA>(high); writePort<PB>(high); writePort<PC>(high);
+    writePort<PD>(high); writePort<PE>(high); writePort<PF>(high);
+    writePort<PG>(high); writePort<PH>(high); writePort<PJ>(high);
+    writePort<PK>(high); writePort<PL>(high);
+    SREG = sreg;
+#else
+    for(uint8_t i = 0; i < SEVEN_SEGMENTS; i++){
+      digitalWrite(pin(i), (high & SEG_BIT(i)) ? HIGH : LOW);
+    }
+#endif
+  }
+};
+
+/*
+ * DigitPins type binds the segment pins of every statically driven
+ * digit at compile time (first SegmentPins = frame digit 0)
+ */
+template<class... SEGS> struct DigitPins;
+
+template<>
+struct DigitPins<>{
+  static const uint8_t COUNT = 0;
+  static inline void write(uint8_t, uint8_t){}
+  static uint8_t pin(uint8_t, uint8_t){ return 0xFF; }
+  static void begin(){}
+};
+
+template<class SEGS, class... REST>
+struct DigitPins<SEGS, REST...>{
+  static const uint8_t COUNT = 1 + sizeof...(REST);
+
+  // Displays a packed glyph on one digit
+  static inline void write(uint8_t digit, uint8_t glyph){
+    if(digit == 0) SEGS::write(glyph);
+    else DigitPins<REST...>::write(digit - 1, glyph);
+  }
+
+  // Pin number of a digit's segment (0 = A)
+  static uint8_t pin(uint8_t digit, uint8_t seg){
+    return digit == 0 ? SEGS::pin(seg) : DigitPins<REST...>::pin(digit - 1, seg);
+  }
+
+  // Configures the segment pins of every digit as outputs
+  static void begin(){
+    SEGS::begin();
+    DigitPins<REST...>::begin();
+  }
+};
+
+/*
+ * PlayerPins type binds a player's button and the frame digits of its
+ * score at compile time (FIRST = frame digit of the leading digit)
+ */
+template<uint8_t BUTTON, uint8_t FIRST, uint8_t COUNT>
+struct PlayerPins{
+  static const uint8_t BUTTON_PIN = BUTTON; // Button input pin
+  static const uint8_t FIRST_DIGIT = FIRST; // Frame digit of the leading digit
+  static const uint8_t DIGITS = COUNT;      // Digits of the score
+  static_assert(COUNT >= 1 && COUNT <= SCORE_DIGITS, "1 -> SCORE_DIGITS digits");
+
+  // Raw button level (HIGH = pressed)
+  static inline bool readButton(){
+    return PORT_IN(pinPort(BUTTON)) & pinMask(BUTTON);
+  }
+};
+
+/*
+ * PlayerList type binds the pins of every player at compile time (first
+ * PlayerPins = player 0), looked up at run time by player index
+ */
+template<class... PINS> struct PlayerList;
+
+template<>
+struct PlayerList<>{
+  static const uint8_t COUNT = 0;
+  static const uint8_t DIGITS = 0;
+  static inline uint8_t readButtons(){ return 0; }
+  static uint8_t button(uint8_t){ return 0xFF; }
+  static uint8_t firstDigit(uint8_t){ return 0; }
+  static uint8_t digits(uint8_t){ return 0; }
+};
+
+template<class PINS, class... REST>
+struct PlayerList<PINS, REST...>{
+  static const uint8_t COUNT = 1 + sizeof...(REST);
+  static const uint8_t DIGITS = PINS::DIGITS + PlayerList<REST...>::DIGITS;
+
+  // Raw button levels, bit n = player n (1 = pressed)
+  static inline uint8_t readButtons(){
+    return PINS::readButton() | PlayerList<REST...>::readButtons() << 1;
+  }
+
+  // Button pin of a player
+  static uint8_t button(uint8_t player){
+    if(player == 0) return PINS::BUTTON_PIN;
+    return PlayerList<REST...>::button(player - 1);
+  }
+
+  // Frame digit of a player's leading digit
+  static uint8_t firstDigit(uint8_t player){
+    if(player == 0) return PINS::FIRST_DIGIT;
+    return PlayerList<REST...>::firstDigit(player - 1);
+  }
+
+  // Digits of a player's score
+  static uint8_t digits(uint8_t player){
+    if(player == 0) return PINS::DIGITS;
+    return PlayerList<REST...>::digits(player - 1);
+  }
+
+  // Frame digit of a player's ones place
+  static uint8_t onesDigit(uint8_t player){
+    return firstDigit(player) + digits(player) - 1;
+  }
+};
+
+// Player pin assignments (button, first frame digit, digits)
+typedef PlayerPins<P1_BUTTON, 0, 2> P1Pins;
+typedef PlayerPins<P2_BUTTON, 2, 2> P2Pins;
+typedef PlayerList<P1Pins, P2Pins> AllPlayers;
+static_assert(AllPlayers::COUNT == NUM_PLAYERS, "1 PlayerPins per player");
+static_assert(AllPlayers::DIGITS == FRAME_DIGITS, "players fill the frame");
+static_assert(NUM_PLAYERS <= 8, "button levels are packed in a byte");
+
+#if DISPLAY_BACKEND == DISPLAY_STATIC
+// Static pin assignments, 1 SegmentPins per frame digit
+typedef DigitPins<SegmentPins<2, 3, 4, 5, 6, 7, 8>,
+                  SegmentPins<14, 15, 16, 17, 18, 19, 20>,
+                  SegmentPins<22, 24, 26, 28, 30, 32, 34>,
+                  SegmentPins<23, 25, 27, 29, 31, 33, 35> > StaticDigits;
+static_assert(StaticDigits::COUNT == FRAME_DIGITS, "segment pins per digit");
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+// Multiplexed pin assignments (segments A -> G all on PORTA)
+typedef SegmentPins<22, 23, 24, 25, 26, 27, 28> MuxSegments;
+typedef DigitSelect<30, 31, 32, 33> MuxEnables;
+static_assert(MuxEnables::COUNT == FRAME_DIGITS, "1 enable pin per digit");
+#endif
+
+/*
+ * Player type keeps track of its score (binary, plus its digit values
+ * cached for display), button hold start time, and button states
+ * (current & previous). Pins live in PlayerPins
  */
 typedef struct{
-  uint8_t d1_pins[7];     // Pin numbers for first digit display
-  uint8_t d2_pins[7];     // Pin numbers for second digit display
-  uint8_t d1_num;         // Tens place score value
-  uint8_t d2_num;         // Ones Place score value
+  uint16_t score;         // Score, only changed through setScore()
+  uint8_t digits[SCORE_DIGITS]; // Cached digits of score, [0] = ones place
+  uint8_t num_digits;     // Digits of the score in use (PlayerPins::DIGITS)
+  uint8_t dirty;          // Bit per digit changed since last rendered
   unsigned long start;    // Start time for button hold period
   bool button_state;      // 1 = button pressed
   bool prev_button_state; // 0 = last state was off
+  bool hold_reported;     // 1 = hold event already sent for this press
+#ifdef WATCHDOG_RESET
+  bool long_hold_reported; // 1 = long hold event already sent for this press
+#endif
+  bool raw_level;         // Last raw button level seen
+#if BUTTON_CAPTURE_IRQ
+  unsigned long lock_start; // Start time of the debounce lockout
+  bool settling;          // 1 = lockout running, level not yet accepted
+#else
+  uint8_t integrator;     // Debounce integrator (0 -> DEBOUNCE_SAMPLES)
+#endif
+  int8_t shown[SCORE_DIGITS]; // Value rendered per digit (-1 = blank)
+#ifdef LATENCY_TRACE
+  unsigned long edge_us;  // micros() of the last raw button edge
+  unsigned long trace_us; // Edge time of the release being traced
+  int8_t trace_digit;     // Ones value that ends the trace (-1 = none)
+#endif
 } Player;
 
 /*===================================================================*\   
 |                           GLOBAL VARIABLES                          |
 \*===================================================================*/
 
-Player p1; // Player type for player 1
-Player p2; // Player type for player 2
+Player players[NUM_PLAYERS]; // Player 0 = Player 1
 bool winner_found; // Winner found flag
-bool p1_is_winner; // TRUE = Player 1 has won, FALSE = Player 2 has won
+uint8_t winner;    // Index of the winning player
+unsigned long last_refresh; // Time of last forced full display refresh
+unsigned long last_sample;  // Time of last button sample
+BlinkPhase blink_phase;     // Current phase of the winning score blink
+unsigned long blink_start;  // Start time of the current blink phase
+
+#if DISPLAY_REFRESH_ISR
+/*
+ * Double-buffered display frame, values per digit (-1 = blank). The ISR
+ * displays frames[frame_front], loop() composes the other buffer and
+ * requests a swap only once the previous swap has been taken
+*/
+volatile int8_t frames[2][FRAME_DIGITS];
+volatile uint8_t frame_front; // Index of the frame shown by the ISR
+volatile bool frame_swap;     // TRUE = back frame is ready to be shown
+bool frame_dirty;             // TRUE = rendered values not yet committed
+bool frame_full;              // TRUE = full refresh not yet committed
+volatile bool frame_force;    // TRUE = pending frame is a full refresh
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+uint8_t mux_digit; // Frame digit currently lit (ISR)
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595
+uint8_t shift_frame[FRAME_DIGITS]; // Glyph per 595, sent on displayFlush()
+bool shift_dirty;                  // TRUE = shift_frame not yet latched
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MAX7219
+/*
+ * Shadow of the MAX7219 digit registers as packed glyphs. Only digits
+ * whose glyph changed are sent on displayFlush()
+*/
+uint8_t max_digits[FRAME_DIGITS]; // Glyph held by each digit register
+uint8_t max_dirty;                // Bit per digit register not yet sent
+static_assert(FRAME_DIGITS <= 8, "MAX7219 drives up to 8 digits");
+#endif
+
+#ifdef LOOP_STATS
+Histogram loop_hist;        // Intervals between loop() passes
+unsigned long loop_last_us; // micros() at the start of the last pass
+#endif
+
+#ifdef LATENCY_TRACE
+Histogram latency_hist; // Release edge -> new score on the segment pins
+#endif
+
+#if BUTTON_CAPTURE_IRQ
+/*
+ * Lock-free single-producer/single-consumer ring of button edges. Only
+ * interrupts advance edge_head, only loop() advances edge_tail
+*/
+volatile ButtonEdge edge_ring[EDGE_RING_SIZE];
+volatile uint8_t edge_head;         // Next slot to write (ISR)
+volatile uint8_t edge_tail;         // Next slot to read (loop)
+uint8_t edge_levels;                // Last captured levels, bit n = player n (ISR)
+#endif
+
+/*
+ * Ruleset descriptors, indexed by the RULES_* macros. Also kept in flash
+ * for selecting one from EEPROM at run time
+*/
+constexpr Ruleset RULESETS[] PROGMEM =
+{
+  { 21, 2,  0, 1 }, // RULES_CLASSIC
+  { 11, 2,  0, 3 }, // RULES_PICKLEBALL
+  { 11, 2,  0, 5 }, // RULES_TABLE_TENNIS
+  { 15, 2,  0, 3 }, // RULES_RALLY_15
+  { 25, 2,  0, 5 }, // RULES_VOLLEYBALL
+  { 21, 2, 30, 3 }  // RULES_BADMINTON
+};
+#define RULESET_COUNT (sizeof(RULESETS) / sizeof(RULESETS[0]))
+static_assert(RULESET < RULESET_COUNT, "RULESET is not in RULESETS");
+
+#ifdef RULES_FROM_EEPROM
+Ruleset rules; // Ruleset played, loaded by loadRules()
+#else
+constexpr Ruleset rules = RULESETS[RULESET]; // Ruleset played, folds into compares
+#endif
+
+/*
+ * @brief Most games per match of any ruleset
+ * @param i -> First RULESETS index to consider
+*/
+constexpr uint8_t mostGames(uint8_t i) {
+  return i >= RULESET_COUNT ? 0 :
+         RULESETS[i].games > mostGames(i + 1) ? RULESETS[i].games : mostGames(i + 1);
+}
+#define MATCH_MAX_GAMES mostGames(0)
+
+/*
+ * Match state. A game win is recorded once, after its blink the next
+ * game starts in place (no reset) until a player has won the match
+*/
+uint8_t games_won[NUM_PLAYERS];            // Games won this match per player
+uint8_t games_played;                      // Games finished this match
+GameRecord game_history[MATCH_MAX_GAMES];  // Final score of each game
+bool match_over;                // TRUE = a player has won the match
+bool show_standings;            // TRUE = games won shown in place of scores
+unsigned long game_over_start;  // Time the last game was won
+
+#ifdef RESUME_GAME
+/*
+ * SavedGame type is a copy of the live game state that survives a reset
+ * (RESET pin, brownout, watchdog) in RAM the C runtime leaves untouched
+ */
+typedef struct{
+  uint16_t magic;                      // SAVED_GAME_MAGIC
+  uint16_t score[NUM_PLAYERS];         // Score per player
+  uint8_t games_won[NUM_PLAYERS];      // Games won this match per player
+  uint8_t games_played;                // Games finished this match
+  GameRecord history[MATCH_MAX_GAMES]; // Final score of each game
+  bool winner_found;                   // Winner found flag
+  uint8_t winner;                      // Index of the winning player
+  bool match_over;                     // TRUE = a player has won the match
+  uint16_t crc;                        // CRC-16 of every field above
+} SavedGame;
+
+SavedGame saved_game __attribute__((section(".noinit"))); // Updated on change
+#endif
+
+#ifdef EVENT_LOG
+/*
+ * Ring of log events, oldest dropped (whole) to make room. Only loop()
+ * logs, so no locking is needed
+*/
+uint8_t event_log[EVENT_LOG_SIZE];
+uint16_t log_head;       // Next byte to write
+uint16_t log_tail;       // Header of the oldest event
+unsigned long log_ms;    // Time of the newest event, in whole ticks
+unsigned long log_start; // Time the oldest event counts its ticks from
+#endif
+
+#ifdef SCORE_JOURNAL
+/*
+ * Score journal, a ring of 1 byte records over the EEPROM after the
+ * settings. Every slot is written once per pass (wear leveling), and the
+ * lap bit of each record tells the slots of this pass from the last.
+ * loop() queues records, the EEPROM ready ISR writes them 1 at a time
+*/
+volatile uint8_t journal_queue[JOURNAL_QUEUE_SIZE]; // Records not yet written
+volatile uint8_t journal_head; // Next queue slot to fill (loop)
+volatile uint8_t journal_tail; // Next queue slot to write (ISR)
+uint16_t journal_pos;          // Next journal slot to write (ISR after setup)
+uint8_t journal_lap;           // Lap bit of this pass (ISR after setup)
+#endif
 
 /*
- * Segment level values to display digits
+ * Packed segment glyphs stored in flash, 1 = segment lit (A = bit 7 ->
+ * G = bit 1, bit 0 unused). Each is the complement of the header's hex
 */
-byte displayLEDs[NUM_DIGITS][SEVEN_SEGMENTS] = 
+const uint8_t SEGMENT_GLYPHS[NUM_DIGITS] PROGMEM =
 {
-    {ON, ON, ON, ON, ON, ON, OFF},    // 0
-    {OFF, ON, ON, OFF, OFF, OFF, OFF},// 1
-    {ON, ON, OFF, ON, ON, OFF, ON},   // 2
-    {ON, ON, ON, ON, OFF, OFF, ON},   // 3
-    {OFF, ON, ON, OFF, OFF, ON, ON},  // 4
-    {ON, OFF, ON, ON, OFF, ON, ON},   // 5
-    {ON, OFF, ON, ON, ON, ON, ON},    // 6
-    {ON, ON, ON, OFF, OFF, OFF, OFF}, // 7
-    {ON, ON, ON, ON, ON, ON, ON},     // 8
-    {ON, ON, ON, ON, OFF, ON, ON}     // 9
+  0xFC, // 0
+  0x60, // 1
+  0xDA, // 2
+  0xF2, // 3
+  0x66, // 4
+  0xB6, // 5
+  0xBE, // 6
+  0xE0, // 7
+  0xFE, // 8
+  0xF6  // 9
 };
 
 /*===================================================================*\   
                              FUNCTIONS                                |
 \*===================================================================*/
 
+#ifdef STATS_SERIAL
 /*
- * @brief Displays a tens place value
- * @param p Player to update
- * @param num Value to update to
- * In Range Values : 0 -> 9
- * Out of range : displays blank segment
+ * @brief Empties a histogram
 */
-void displayFirstDigit(const Player& p, int num){
-  for( int i = 0; i < SEVEN_SEGMENTS; i++){
-    if(num < 0 || num >= NUM_DIGITS) {
-        digitalWrite(p.d1_pins[i], OFF);  // all segments off
-    } else {
-        digitalWrite(p.d1_pins[i], displayLEDs[num][i]);
-    }
-  }
+void histClear(Histogram& h) {
+  memset(&h, 0, sizeof(h));
+  h.min = ~0UL;
 }
 
 /*
- * @brief Displays a ones place value
- * @param p   -> Player to update
- * @param num -> Value to update to (blank if out of range)
- * In Range Values : 0 -> 9
- * Out of range : displays blank segment
+ * @brief Adds a sample to a histogram
+ * @param us -> Duration in microseconds
+*/
+void histAdd(Histogram& h, unsigned long us) {
+  uint8_t b = us < 2 ? 0 : 8 * sizeof(us) - 1 - __builtin_clzl(us);
+  if(b >= HIST_BUCKETS) b = HIST_BUCKETS - 1;
+  h.count[b]++;
+  h.n++;
+  if(us < h.min) h.min = us;
+  if(us > h.max) h.max = us;
+}
+
+/*
+ * @brief Upper bound of the bucket holding a percentile
+ * @param pct -> Percentile (1 -> 100)
 */
-void displaySecondDigit(const Player& p, int num){
-  for( int i = 0; i < SEVEN_SEGMENTS; i++){
-    if(num < 0 || num >= NUM_DIGITS) {
-        digitalWrite(p.d2_pins[i], OFF);  // all segments off
-    } else {
-        digitalWrite(p.d2_pins[i], displayLEDs[num][i]);
+unsigned long histPercentile(const Histogram& h, uint8_t pct) {
+  // ceil(n * pct / 100), split so n * pct cannot overflow 32 bits
+  unsigned long target = h.n / 100 * pct + (h.n % 100 * pct + 99) / 100;
+  unsigned long seen = 0;
+  for(uint8_t b = 0; b < HIST_BUCKETS; b++) {
+    seen += h.count[b];
+    if(seen >= target) {
+      unsigned long bound = (2UL << b) - 1;
+      return bound < h.max ? bound : h.max;
     }
   }
+  return h.max;
 }
 
 /*
- * @brief Blinks the score of the provided player
- * @param p -> The winning player
+ * @brief Prints a histogram's summary and non-empty buckets over Serial
+ * @param name -> Label printed before the summary
 */
-void blinkWinner(const Player& p) {
-  displayFirstDigit(p, -1);  // displays blank
-  displaySecondDigit(p, -1); // displays blank
-  delay(SCORE_BLINK_MS);
-  displayFirstDigit(p, p.d1_num);
-  displaySecondDigit(p, p.d2_num);
-  delay(SCORE_BLINK_MS);
+void histDump(const Histogram& h, const char* name) {
+  Serial.print(name);
+  Serial.print(F(" n="));
+  Serial.print(h.n);
+  if(h.n) {
+    Serial.print(F(" min="));
+    Serial.print(h.min);
+    Serial.print(F(" max="));
+    Serial.print(h.max);
+    Serial.print(F(" p50<="));
+    Serial.print(histPercentile(h, 50));
+    Serial.print(F(" p99<="));
+    Serial.print(histPercentile(h, 99));
+  }
+  Serial.println(F(" us"));
+
+  for(uint8_t b = 0; b < HIST_BUCKETS; b++) {
+    if(!h.count[b]) continue;
+    Serial.print(F("  >="));
+    Serial.print(b ? 1UL << b : 0UL);
+    Serial.print(F(" us: "));
+    Serial.println(h.count[b]);
+  }
 }
 
+#endif
+
+#ifdef EVENT_LOG
 /*
- * @brief Conducts a full board reset 
+ * @brief Ticks since the previous event of the event at a log position
+ * @param pos -> Position of the event's header
 */
-void reset_game() {
-  pinMode(RESET, OUTPUT); // signals reset pin
+uint16_t logTicks(uint16_t pos) {
+  uint8_t bytes = LOG_DT_BYTES(event_log[pos]);
+  uint16_t ticks = 0;
+  for(uint8_t i = bytes; i > 0; i--) {
+    ticks = ticks << 8 | event_log[(pos + i) & (EVENT_LOG_SIZE - 1)];
+  }
+  return ticks;
 }
 
 /*
- * @brief Handles button events for p (Pressed, Held, Released)
- * @param p Player to handle button of
+ * @brief Appends one event, dropping the oldest until it fits
+ * @param type   -> LOG_* event type
+ * @param player -> Player index (0 if none)
+ * @param ticks  -> Ticks since the previous event
 */
-void handle_button(Player& p) {
-  // DETERMINE BUTTON STATE
-  p.button_state = digitalRead((&p == &p1) ? P1_BUTTON : P2_BUTTON);
+void logWrite(uint8_t type, uint8_t player, uint16_t ticks) {
+  uint8_t bytes = ticks > 0xFF ? 2 : ticks ? 1 : 0;
 
-  // ON BUTTON PRESS
-  if(p.button_state && !p.prev_button_state) {
-    p.start = millis();
-    delay(BUTTON_PRESS_LENGTH);
-  }
-  // ON BUTTON HOLD
-  else if(p.button_state && p.prev_button_state) {
-    if(millis() - p.start >= BUTTON_HOLD_MS) { // hold has exceeded time limit
-      reset_game();
-    }
+  // MAKE ROOM
+  while(((log_tail - log_head - 1) & (EVENT_LOG_SIZE - 1)) < 1 + bytes) {
+    log_start += (unsigned long)logTicks(log_tail) * LOG_TICK_MS;
+    log_tail = (log_tail + LOG_SIZE(event_log[log_tail])) & (EVENT_LOG_SIZE - 1);
   }
-  // ON BUTTON RELEASE
-  else if(!p.button_state && p.prev_button_state) {
-    if(!winner_found){
-      // INCREMENT SCORE
-      p.d2_num++; 
-      if(p.d2_num >= NUM_DIGITS){
-        p.d1_num++;
-        p.d2_num = 0;              
-      }
-    }
+
+  // HEADER, THEN TICKS LSB FIRST
+  event_log[log_head] = LOG_HEADER(type, player, bytes);
+  log_head = (log_head + 1) & (EVENT_LOG_SIZE - 1);
+  for(uint8_t i = 0; i < bytes; i++, ticks >>= 8) {
+    event_log[log_head] = ticks & 0xFF;
+    log_head = (log_head + 1) & (EVENT_LOG_SIZE - 1);
   }
-  
-  p.prev_button_state = p.button_state;
 }
 
-/*===================================================================*\   
-|                                SETUP()                              |
-\*===================================================================*/
-
-void setup() {
-  // INITIALIZE GLOBALS
-  winner_found = false;
-  p1_is_winner = false;
-
-  // =========== Player 1 ============ //
-  p1 = { 
-    .d1_pins = {2,3,4,5,6,7,8},
-    .d2_pins = {14,15,16,17,18,19,20},
-    .d1_num = 0,
-    .d2_num = 0,
-    .start = 0,
-    .button_state = LOW,
-    .prev_button_state = LOW
-  };
-
-  // =========== Player 2 ============ //
-  p2 = { 
-    .d1_pins = {22,24,26,28,30,32,34},
-    .d2_pins = {23,25,27,29,31,33,35},
-    .d1_num = 0,
-    .d2_num = 0,
-    .start = 0,
-    .button_state = LOW,
-    .prev_button_state = LOW
-  };
+/*
+ * @brief Logs a game event at the current time
+ * @param type   -> LOG_* event type
+ * @param player -> Player index (0 if none)
+*/
+void logEvent(uint8_t type, uint8_t player) {
+  unsigned long ticks = (millis() - log_ms) / LOG_TICK_MS;
+  log_ms += ticks * LOG_TICK_MS;
 
-  // SET OUTPUT PINS
-  for(int i = 0; i < SEVEN_SEGMENTS; i++){
-    pinMode(p1.d1_pins[i], OUTPUT);
-    pinMode(p1.d2_pins[i], OUTPUT);
-    pinMode(p2.d1_pins[i], OUTPUT);
-    pinMode(p2.d2_pins[i], OUTPUT);
-  }
+  // PAD GAPS TOO LONG FOR 1 EVENT
+  for(; ticks > LOG_DT_MAX; ticks -= LOG_DT_MAX) logWrite(LOG_IDLE, 0, LOG_DT_MAX);
+  logWrite(type, player, ticks);
+}
 
-  // SET INPUT PINS
-  pinMode(P1_BUTTON, INPUT);
-  pinMode(P2_BUTTON, INPUT);
+/*
+ * @brief Empties the log, later events count their ticks from now
+*/
+void logClear() {
+  log_head = 0;
+  log_tail = 0;
+  log_ms = millis();
+  log_start = log_ms;
 }
 
-/*===================================================================*\   
-|                                 LOOP()                              |
+/*
+ * @brief Prints the log over Serial as hex, oldest event first
+ * "log t0=<ms> n=<bytes>" then 16 bytes per line, for sim/logdecode
+*/
+void logDump() {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  uint16_t n = (log_head - log_tail) & (EVENT_LOG_SIZE - 1);
+  Serial.print(F("log t0="));
+  Serial.print(log_start);
+  Serial.print(F(" n="));
+  Serial.println(n);
+  for(uint16_t i = 0; i < n; i++) {
+    uint8_t b = event_log[(log_tail + i) & (EVENT_LOG_SIZE - 1)];
+    Serial.write(HEX_DIGITS[b >> 4]);
+    Serial.write(HEX_DIGITS[b & 0x0F]);
+    if(i % 16 == 15 || i == n - 1) Serial.println();
+    else Serial.write(' ');
+  }
+}
+#endif
+
+#ifdef LATENCY_TRACE
+/*
+ * @brief Starts timing the release that just changed p's score
+ * @param p -> Player whose score changed
+*/
+void traceRelease(Player& p) {
+  // HAND OVER TO THE REFRESH ISR (edge time first, then the digit arms it)
+  noInterrupts();
+  p.trace_us = p.edge_us;
+  p.trace_digit = p.digits[0];
+  interrupts();
+}
+
+/*
+ * @brief Ends p's latency trace once its new score reaches the pins
+ * @param p   -> Player whose second digit was written
+ * @param num -> Value written
+*/
+void traceShown(Player& p, int num) {
+  if(p.trace_digit < 0 || num != p.trace_digit) return;
+  histAdd(latency_hist, micros() - p.trace_us);
+  p.trace_digit = -1;
+}
+#endif
+
+/*
+ * @brief Looks up the packed glyph of a value
+ * @param num -> Value to display (blank if out of range)
+*/
+uint8_t digitGlyph(int num){
+  if(num < 0 || num >= NUM_DIGITS) return GLYPH_BLANK;
+  return pgm_read_byte(&SEGMENT_GLYPHS[num]);
+}
+
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595 || DISPLAY_BACKEND == DISPLAY_MAX7219
+/*
+ * @brief Starts hardware SPI as master at F_CPU / 2, MSB first, mode 0
+ * @param ss -> Latch/load pin on SS, must stay an output to keep master
+*/
+void startSpi(uint8_t ss){
+  pinMode(SPI_MOSI_PIN, OUTPUT);
+  pinMode(SPI_SCK_PIN, OUTPUT);
+  pinMode(ss, OUTPUT);
+  digitalWrite(ss, HIGH);
+  SPCR = _BV(SPE) | _BV(MSTR);
+  SPSR = _BV(SPI2X);
+}
+
+/*
+ * @brief Sends one byte over SPI, waiting for it to complete
+ * @param data -> Byte to send (MSB first)
+*/
+inline void spiSend(uint8_t data){
+  SPDR = data;
+  while(!(SPSR & _BV(SPIF)));
+}
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595
+/*
+ * @brief Sets a 595's glyph, latched by the next displayFlush()
+ * @param digit -> Frame digit
+ * @param glyph -> Packed glyph
+*/
+void shiftDigit(uint8_t digit, uint8_t glyph){
+  if(shift_frame[digit] == glyph) return;
+  shift_frame[digit] = glyph;
+  shift_dirty = true;
+}
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MAX7219
+/*
+ * @brief Sets a digit register's glyph, sent by the next displayFlush()
+ * @param digit -> Frame digit
+ * @param glyph -> Packed glyph
+*/
+void maxDigit(uint8_t digit, uint8_t glyph){
+  if(max_digits[digit] == glyph) return;
+  max_digits[digit] = glyph;
+  max_dirty |= 1 << digit;
+}
+
+/*
+ * @brief Writes one MAX7219 register
+ * @param reg  -> Register address
+ * @param data -> Register value
+*/
+void maxWrite(uint8_t reg, uint8_t data){
+  FastPin<MAX7219_LOAD_PIN>::write(LOW);
+  spiSend(reg);
+  spiSend(data);
+  FastPin<MAX7219_LOAD_PIN>::write(HIGH); // rising edge loads the register
+}
+
+/*
+ * @brief Writes the MAX7219 control registers
+ * Repeated on every full refresh, the chip powers up shut down and
+ * forgets its configuration on a brownout
+*/
+void maxConfigure(){
+  maxWrite(MAX7219_DISPLAY_TEST, 0);
+  maxWrite(MAX7219_DECODE_MODE, 0);
+  maxWrite(MAX7219_SCAN_LIMIT, FRAME_DIGITS - 1);
+  maxWrite(MAX7219_INTENSITY_REG, MAX7219_INTENSITY);
+  maxWrite(MAX7219_SHUTDOWN, 1);
+}
+#endif
+
+#if DISPLAY_BACKEND != DISPLAY_MULTIPLEX
+/*
+ * @brief Displays a value on one frame digit
+ * @param digit -> Frame digit to update
+ * @param num   -> Value to update to
+ * In Range Values : 0 -> 9
+ * Out of range : displays blank segment
+*/
+void displayDigit(uint8_t digit, int num){
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595
+  shiftDigit(digit, digitGlyph(num));
+#elif DISPLAY_BACKEND == DISPLAY_MAX7219
+  maxDigit(digit, digitGlyph(num));
+#else
+  StaticDigits::write(digit, digitGlyph(num));
+#endif
+}
+#endif
+
+/*
+ * @brief Pushes digits written since the last call out to the display
+ * @param force -> TRUE = resend everything even if unchanged
+ * Only batched backends buffer writes, pin backends are already current
+*/
+void displayFlush(bool force){
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595
+  if(!force && !shift_dirty) return;
+  shift_dirty = false;
+
+  // SHIFT WHOLE FRAME, DIGIT 0 ENDS UP IN THE LAST 595
+  FastPin<SHIFT_LATCH_PIN>::write(LOW);
+  for(uint8_t i = 0; i < FRAME_DIGITS; i++) spiSend(GLYPH_HIGH(shift_frame[i]));
+  FastPin<SHIFT_LATCH_PIN>::write(HIGH); // rising edge latches all digits
+#elif DISPLAY_BACKEND == DISPLAY_MAX7219
+  if(force){
+    maxConfigure();
+    max_dirty = (1 << FRAME_DIGITS) - 1;
+  }
+
+  // SEND CHANGED DIGIT REGISTERS ONLY
+  for(uint8_t i = 0; max_dirty; i++){
+    if(!(max_dirty & (1 << i))) continue;
+    maxWrite(MAX7219_DIGIT0 + i, max_digits[i] >> 1); // DP A B C D E F G
+    max_dirty &= ~(1 << i);
+  }
+#else
+  (void)force;
+#endif
+}
+
+#if DISPLAY_BACKEND == DISPLAY_SHIFT_595
+/*
+ * @brief Starts SPI and blanks every 595
+*/
+void startShiftRegisters(){
+  startSpi(SHIFT_LATCH_PIN);
+  for(uint8_t i = 0; i < FRAME_DIGITS; i++) shift_frame[i] = GLYPH_BLANK;
+  displayFlush(true);
+}
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MAX7219
+/*
+ * @brief Starts SPI, configures the MAX7219 and blanks every digit
+*/
+void startMax7219(){
+  startSpi(MAX7219_LOAD_PIN);
+  for(uint8_t i = 0; i < FRAME_DIGITS; i++) max_digits[i] = GLYPH_BLANK;
+  displayFlush(true);
+}
+#endif
+
+/*
+ * @brief Renders the digits of a player's score flagged as changed
+ * @param i     -> Index of the player to update
+ * @param blank -> TRUE = display blank instead of the score
+ * @param force -> TRUE = rewrite every digit even if unchanged
+ * Only digits flagged in dirty are visited, so a pass costs nothing
+ * while the score is steady and 1 digit per digit that changed
+*/
+void renderScore(uint8_t i, bool blank, bool force){
+  Player& p = players[i];
+  if(force) p.dirty = 0xFF;
+  p.dirty &= _BV(p.num_digits) - 1;
+
+  while(p.dirty){
+    // NEXT CHANGED DIGIT, LOWEST PLACE FIRST
+    uint8_t place = __builtin_ctz(p.dirty);
+    p.dirty &= p.dirty - 1;
+
+    int8_t num;
+    if(blank) num = -1;
+    else if(show_standings) num = place ? -1 : games_won[i];
+    else num = p.digits[place];
+    if(!force && num == p.shown[place]) continue;
+    p.shown[place] = num;
+#if DISPLAY_REFRESH_ISR
+    frame_dirty = true; // shown by ISR after commitFrame()
+#else
+    displayDigit(AllPlayers::onesDigit(i) - place, num);
+#ifdef LATENCY_TRACE
+    if(place == 0) traceShown(p, num);
+#endif
+#endif
+  }
+}
+
+#if DISPLAY_REFRESH_ISR
+/*
+ * @brief Hands the rendered digit values to the refresh ISR
+ * @param full -> TRUE = frame is a full refresh, resent in full
+ * Deferred to a later call while the previous frame is still pending
+*/
+void commitFrame(bool full){
+  if(full) frame_full = true;
+  if(!frame_dirty || frame_swap) return;
+
+  // COMPOSE BACK FRAME
+  volatile int8_t* back = frames[frame_front ^ 1];
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    uint8_t ones = AllPlayers::onesDigit(i);
+    for(uint8_t place = 0; place < players[i].num_digits; place++){
+      back[ones - place] = players[i].shown[place];
+    }
+  }
+
+  frame_force = frame_full;
+  frame_full = false;
+  frame_dirty = false;
+  frame_swap = true;
+}
+
+/*
+ * @brief Starts Timer1 in CTC mode at TIMER1_HZ
+*/
+void startRefreshTimer(){
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10); // CTC, clk/64
+  OCR1A = F_CPU / 64 / TIMER1_HZ - 1;
+  TIMSK1 = _BV(OCIE1A);
+  interrupts();
+}
+#endif
+
+/*
+ * @brief Checks if the provided player's score is currently blinked off
+ * @param i -> Index of the player to check
+*/
+bool isBlanked(uint8_t i) {
+  return winner_found && blink_phase == BLINK_BLANK && winner == i;
+}
+
+/*
+ * @brief Starts blinking the winning score, beginning with a blank phase
+*/
+void startBlink() {
+  blink_phase = BLINK_BLANK;
+  blink_start = millis();
+  players[winner].dirty = 0xFF;
+}
+
+/*
+ * @brief Advances the winning score blink without blocking
+ * Toggles between blank and score every SCORE_BLINK_MS
+*/
+void blinkWinner() {
+  if(millis() - blink_start >= SCORE_BLINK_MS) {
+    blink_start += SCORE_BLINK_MS;
+    blink_phase = (blink_phase == BLINK_BLANK) ? BLINK_SCORE : BLINK_BLANK;
+    players[winner].dirty = 0xFF;
+  }
+}
+
+/*
+ * @brief Turns a change of p's debounced button state into an event
+ * @param p   -> Player whose button state was updated
+ * @param now -> Time of the update
+*/
+ButtonEvent buttonEvent(Player& p, unsigned long now) {
+  ButtonEvent e = BUTTON_NONE;
+  // ON BUTTON PRESS
+  if(p.button_state && !p.prev_button_state) {
+    p.start = now;
+    p.hold_reported = false;
+#ifdef WATCHDOG_RESET
+    p.long_hold_reported = false;
+#endif
+    e = BUTTON_PRESS;
+  }
+  // ON BUTTON HOLD (reported once per press)
+  else if(p.button_state && p.prev_button_state) {
+    if(!p.hold_reported && now - p.start >= BUTTON_HOLD_MS) {
+      p.hold_reported = true;
+      e = BUTTON_HOLD;
+    }
+#ifdef WATCHDOG_RESET
+    else if(!p.long_hold_reported && now - p.start >= HARD_RESET_HOLD_MS) {
+      p.long_hold_reported = true;
+      e = BUTTON_LONG_HOLD;
+    }
+#endif
+  }
+  // ON BUTTON RELEASE
+  else if(!p.button_state && p.prev_button_state) {
+    e = BUTTON_RELEASE;
+  }
+
+  p.prev_button_state = p.button_state;
+  return e;
+}
+
+#if !BUTTON_CAPTURE_IRQ
+/*
+ * @brief Filters one raw button sample and reports the resulting event
+ * @param p   -> Player whose button was sampled
+ * @param raw -> Raw button level (HIGH = pressed)
+ * A new level is accepted once the integrator saturates, which takes
+ * DEBOUNCE_SAMPLES consecutive agreeing samples
+*/
+ButtonEvent debounceButton(Player& p, bool raw) {
+#ifdef LATENCY_TRACE
+  if(raw != p.raw_level) p.edge_us = micros();
+#endif
+  p.raw_level = raw;
+
+  // INTEGRATE SAMPLE
+  if(raw && p.integrator < DEBOUNCE_SAMPLES) {
+    p.integrator++;
+  } else if(!raw && p.integrator > 0) {
+    p.integrator--;
+  }
+
+  // ACCEPT LEVEL AT INTEGRATOR LIMITS
+  if(p.integrator == DEBOUNCE_SAMPLES) {
+    p.button_state = HIGH;
+  } else if(p.integrator == 0) {
+    p.button_state = LOW;
+  }
+
+  return buttonEvent(p, millis());
+}
+#endif
+
+#ifdef RULES_FROM_EEPROM
+/*
+ * @brief Loads the ruleset picked by the index stored in EEPROM
+ * Falls back to RULESET when the index is invalid (blank EEPROM = 0xFF)
+*/
+void loadRules() {
+  uint8_t index = eeprom_read_byte((const uint8_t*)RULES_EEPROM_ADDR);
+  if(index >= RULESET_COUNT) index = RULESET;
+  memcpy_P(&rules, &RULESETS[index], sizeof(rules));
+}
+#endif
+
+/*
+ * @brief Records the game just won by the winner in the match
+ * Ends the match once the winner holds a majority of its games
+*/
+void recordGame() {
+  if(games_played < MATCH_MAX_GAMES) {
+    GameRecord& game = game_history[games_played];
+    for(uint8_t i = 0; i < NUM_PLAYERS; i++) game.score[i] = players[i].score;
+  }
+  games_played++;
+  games_won[winner]++;
+  match_over = games_won[winner] * 2 > rules.games;
+  game_over_start = millis();
+}
+
+/*
+ * @brief Checks for winning conditions, run only when a score changes
+ * The leader must reach the target and lead the runner-up by the
+ * margin, or reach the cap. With a build time ruleset every rule is a
+ * compare against a constant (a cap of 0 compiles out)
+*/
+void checkWinner() {
+  if(winner_found) return;
+
+  // FIND LEADER & RUNNER-UP
+  uint16_t lead = 0, runner_up = 0;
+  uint8_t leader = 0;
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) {
+    uint16_t score = players[i].score;
+    if(score > lead) {
+      runner_up = lead;
+      lead = score;
+      leader = i;
+    } else if(score > runner_up) {
+      runner_up = score;
+    }
+  }
+
+  // CHECK TARGET & MARGIN, OR CAP
+  if((lead >= rules.target && lead - runner_up >= rules.margin) ||
+     (rules.cap && lead >= rules.cap)) {
+    winner_found = true;
+    winner = leader;
+    recordGame();
+    startBlink();
+  }
+}
+
+#ifdef RESUME_GAME
+/*
+ * @brief CRC-16 of the saved game, every field before crc
+*/
+uint16_t savedGameCrc() {
+  uint16_t crc = 0xFFFF;
+  const uint8_t* data = (const uint8_t*)&saved_game;
+  for(size_t i = 0; i < offsetof(SavedGame, crc); i++) crc = _crc16_update(crc, data[i]);
+  return crc;
+}
+
+/*
+ * @brief Copies the live game state to saved_game
+ * Called on every change, a few microseconds and no EEPROM wear
+*/
+void saveGame() {
+  saved_game.magic = SAVED_GAME_MAGIC;
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) {
+    saved_game.score[i] = players[i].score;
+    saved_game.games_won[i] = games_won[i];
+  }
+  saved_game.games_played = games_played;
+  memcpy(saved_game.history, game_history, sizeof(game_history));
+  saved_game.winner_found = winner_found;
+  saved_game.winner = winner;
+  saved_game.match_over = match_over;
+  saved_game.crc = savedGameCrc();
+}
+#endif
+
+#ifdef SCORE_JOURNAL
+/*
+ * @brief Reads a journal record
+ * @param slot -> Journal slot (0 -> JOURNAL_SLOTS - 1)
+*/
+uint8_t journalRead(uint16_t slot) {
+  return eeprom_read_byte((const uint8_t*)(uintptr_t)(JOURNAL_EEPROM_START + slot));
+}
+
+/*
+ * @brief Finds the slot the next record goes to
+ * Slots before it hold this pass's lap bit and slots from it on the
+ * last pass's, so a binary search finds it in 12 reads
+*/
+void startJournal() {
+  uint8_t first = journalRead(0) & JOURNAL_LAP;
+  uint16_t lo = 1, hi = JOURNAL_SLOTS;
+  while(lo < hi) {
+    uint16_t mid = lo + (hi - lo) / 2;
+    if((journalRead(mid) & JOURNAL_LAP) != first) hi = mid;
+    else lo = mid + 1;
+  }
+
+  // EVERY SLOT ON THE SAME LAP: THE NEXT PASS STARTS AT SLOT 0
+  journal_pos = lo == JOURNAL_SLOTS ? 0 : lo;
+  journal_lap = lo == JOURNAL_SLOTS ? first ^ JOURNAL_LAP : first;
+  journal_head = 0;
+  journal_tail = 0;
+}
+
+/*
+ * @brief Queues a record for the EEPROM ready ISR to write
+ * @param record -> Record code (lap bit added when written)
+ * Returns at once. Only waits if records outpace the ~3.4 ms EEPROM
+ * write for a whole queue's worth
+*/
+void journalAppend(uint8_t record) {
+  uint8_t next = (journal_head + 1) & (JOURNAL_QUEUE_SIZE - 1);
+  while(next == journal_tail) delay(1); // queue full, ISR frees a slot
+  journal_queue[journal_head] = record;
+  journal_head = next;
+  EECR |= _BV(EERIE); // fires as soon as the EEPROM is idle
+}
+
+/*
+ * @brief Journals a change to a player's score
+ * @param player -> Index of the player
+ * @param delta  -> Points added (negative to undo), split in -4 -> 3 steps
+*/
+void journalScore(uint8_t player, int delta) {
+  while(delta) {
+    int8_t step = delta > 3 ? 3 : delta < -4 ? -4 : delta;
+    journalAppend(JOURNAL_SCORE(player, step));
+    delta -= step;
+  }
+}
+
+/*
+ * @brief Writes the next queued record once the EEPROM is idle
+ * Stops itself when the queue is empty
+*/
+ISR(EE_READY_vect) {
+  if(journal_tail == journal_head) {
+    EECR &= ~_BV(EERIE);
+    return;
+  }
+  EEAR = JOURNAL_EEPROM_START + journal_pos;
+  EEDR = journal_queue[journal_tail] | journal_lap;
+  EECR |= _BV(EEMPE);
+  EECR |= _BV(EEPE); // within 4 cycles of EEMPE, interrupts are off
+  journal_tail = (journal_tail + 1) & (JOURNAL_QUEUE_SIZE - 1);
+  if(++journal_pos == JOURNAL_SLOTS) {
+    journal_pos = 0;
+    journal_lap ^= JOURNAL_LAP;
+  }
+}
+#endif
+
+/*
+ * @brief Highest score a number of digits can show (99 for 2 digits)
+ * @param digits -> Digits of the score
+*/
+constexpr uint16_t scoreLimit(uint8_t digits) {
+  return digits ? scoreLimit(digits - 1) * NUM_DIGITS + NUM_DIGITS - 1 : 0;
+}
+
+/*
+ * @brief Stores a player's score and updates its cached digits
+ * @param p     -> Player to update
+ * @param score -> New score (held at the most p's digits can show)
+ * The only place scores are split into digits, and only digits whose
+ * value changed are flagged for rendering. Returns FALSE if unchanged
+*/
+bool storeScore(Player& p, uint16_t score) {
+  uint16_t limit = scoreLimit(p.num_digits);
+  if(score > limit) score = limit;
+  if(score == p.score) return false;
+  p.score = score;
+
+  // DECOMPOSE INTO DIGITS
+  for(uint8_t place = 0; place < p.num_digits; place++) {
+    uint8_t num = score % NUM_DIGITS;
+    score /= NUM_DIGITS;
+    if(num != p.digits[place]) {
+      p.digits[place] = num;
+      p.dirty |= _BV(place);
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Sets a player's score, raising the score change event that
+ * runs the game rules
+ * @param p     -> Player to update
+ * @param score -> New score (held at the most p's digits can show)
+*/
+void setScore(Player& p, uint16_t score) {
+  if(!storeScore(p, score)) return;
+
+  // SCORE CHANGE EVENT
+  checkWinner();
+#ifdef RESUME_GAME
+  saveGame();
+#endif
+}
+
+/*
+ * @brief Adds points to a player's score, or takes them away
+ * @param p     -> Player to update
+ * @param delta -> Points to add (negative to undo), result held >= 0
+*/
+void addScore(Player& p, int delta) {
+  if(delta < 0 && (uint16_t)-delta > p.score) setScore(p, 0);
+  else setScore(p, p.score + delta);
+}
+
+/*
+ * @brief Starts the next game of the match at 0 - 0, without a reset
+ * Players are cleared in order after a won game, so the rules are not
+ * run on the way: 19 - 21 passes through 0 - 21, which would win again
+*/
+void startGame() {
+  winner_found = false;
+  show_standings = false;
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) {
+    storeScore(players[i], 0);
+    players[i].dirty = 0xFF;
+  }
+#ifdef RESUME_GAME
+  saveGame();
+#endif
+}
+
+/*
+ * @brief Moves a won game on to the standings, then the next game
+ * The winning score blinks for GAME_OVER_MS, then every player's games
+ * won shows on their ones digit for STANDINGS_MS
+*/
+void advanceMatch() {
+  unsigned long elapsed = millis() - game_over_start;
+  if(!show_standings && elapsed >= GAME_OVER_MS) {
+    // SHOW GAMES WON
+    show_standings = true;
+    blink_phase = BLINK_SCORE;
+    for(uint8_t i = 0; i < NUM_PLAYERS; i++) players[i].dirty = 0xFF;
+  } else if(show_standings && elapsed >= GAME_OVER_MS + STANDINGS_MS) {
+    startGame();
+#ifdef SCORE_JOURNAL
+    journalAppend(JOURNAL_NEXT_GAME);
+#endif
+#ifdef EVENT_LOG
+    logEvent(LOG_NEXT_GAME, 0);
+#endif
+  }
+}
+
+#ifdef RESUME_GAME
+/*
+ * @brief Picks up the game saved before a reset, if RAM still holds one
+ * Fails after a power cycle (RAM comes up random, so the CRC is wrong).
+ * Scores go onto the 0 - 0 board setup() left one player at a time, so
+ * the rules are not run: a saved 21 - 20 would read as a win at 21 - 0
+*/
+bool resumeGame() {
+  if(saved_game.magic != SAVED_GAME_MAGIC || saved_game.crc != savedGameCrc()) {
+    return false;
+  }
+
+  // RESTORE MATCH, WINNER & SCORES
+  winner_found = saved_game.winner_found;
+  winner = saved_game.winner;
+  match_over = saved_game.match_over;
+  games_played = saved_game.games_played;
+  memcpy(games_won, saved_game.games_won, sizeof(games_won));
+  memcpy(game_history, saved_game.history, sizeof(game_history));
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) storeScore(players[i], saved_game.score[i]);
+  saveGame();
+
+  if(winner_found) {
+    game_over_start = millis();
+    startBlink();
+  }
+  return true;
+}
+#endif
+
+/*
+ * @brief Resets the game and match in place, ready on the next loop pass
+ * No reboot (the old RESET pin hack restarted through the bootloader)
+*/
+void reset_game() {
+  winner = 0;
+  memset(games_won, 0, sizeof(games_won));
+  games_played = 0;
+  match_over = false;
+  startGame();
+}
+
+#ifdef WATCHDOG_RESET
+/*
+ * @brief Conducts a full board reset by letting the watchdog expire
+ * For recovery when a game reset is not enough
+*/
+void hard_reset() {
+  wdt_enable(WDTO_15MS);
+  for(;;) delay(1); // spin until the watchdog bites
+}
+#endif
+
+#ifdef SCORE_JOURNAL
+/*
+ * @brief Rebuilds the game & match from the journal after a power cut
+ * Replays the records since the last reset (a match is far shorter
+ * than the journal), or every record if none was found. Erased records
+ * are skipped, not taken as the start: a write cut off by power reads
+ * back erased, and on odd passes carries the current lap bit
+*/
+void replayJournal() {
+  // WALK BACK TO THE LAST RESET
+  uint16_t slot = journal_pos, count = 0;
+  while(count < JOURNAL_SLOTS) {
+    uint16_t prev = (slot ? slot : JOURNAL_SLOTS) - 1;
+    uint8_t code = journalRead(prev) & JOURNAL_CODE;
+    if(code == JOURNAL_RESET) break;
+    slot = prev;
+    count++;
+  }
+
+  // REPLAY FORWARD
+  for(; count; count--) {
+    uint8_t code = journalRead(slot) & JOURNAL_CODE;
+    if(code == JOURNAL_NEXT_GAME) {
+      startGame();
+    } else if(code < JOURNAL_NEXT_GAME) {
+      int8_t delta = (int8_t)(code << 5) >> 5; // sign extend bits 2:0
+      uint8_t player = code >> 3;
+      if(player < NUM_PLAYERS) addScore(players[player], delta);
+    }
+    if(++slot == JOURNAL_SLOTS) slot = 0;
+  }
+}
+#endif
+
+/*
+ * @brief Handles button events for p (Pressed, Held, Released)
+ * @param p Player to handle button of
+ * @param e Debounced button event
+*/
+void handle_button(Player& p, ButtonEvent e) {
+#ifdef EVENT_LOG
+  uint8_t player = &p - players;
+#endif
+  // ON BUTTON PRESS
+  if(e == BUTTON_PRESS) {
+#ifdef EVENT_LOG
+    logEvent(LOG_PRESS, player);
+#endif
+  }
+  // ON BUTTON HOLD
+  else if(e == BUTTON_HOLD) { // hold has exceeded time limit
+#ifdef EVENT_LOG
+    logEvent(LOG_HOLD, player);
+    logEvent(LOG_RESET, 0);
+#endif
+    reset_game();
+#ifdef SCORE_JOURNAL
+    journalAppend(JOURNAL_RESET);
+#endif
+  }
+#ifdef WATCHDOG_RESET
+  // ON LONG BUTTON HOLD
+  else if(e == BUTTON_LONG_HOLD) {
+    hard_reset();
+  }
+#endif
+  // ON BUTTON RELEASE (not the end of a hold)
+  else if(e == BUTTON_RELEASE) {
+#ifdef EVENT_LOG
+    logEvent(LOG_RELEASE, player);
+#endif
+    if(!winner_found && !p.hold_reported){
+#ifdef LATENCY_TRACE
+      uint16_t before = p.score;
+#endif
+      // INCREMENT SCORE
+      addScore(p, 1);
+#ifdef EVENT_LOG
+      logEvent(LOG_SCORE, player);
+      if(winner_found) logEvent(LOG_WIN, winner);
+#endif
+#ifdef SCORE_JOURNAL
+      journalScore(&p - players, 1);
+#endif
+#ifdef LATENCY_TRACE
+      // (not a clamped score, already shown, or a win, blanked first)
+      if(p.score != before && !winner_found) traceRelease(p);
+#endif
+    }
+  }
+}
+
+#if BUTTON_CAPTURE_IRQ
+/*
+ * @brief Pushes an edge for every button whose level changed
+ * Called from interrupt context only, which makes it the ring's single
+ * producer (AVR interrupts do not nest)
+*/
+void captureButtons() {
+  uint8_t levels = AllPlayers::readButtons();
+
+  uint8_t changed = levels ^ edge_levels;
+  if(!changed) return;
+
+  unsigned long now = millis();
+  for(uint8_t b = 0; b < NUM_PLAYERS; b++) {
+    if(!(changed & _BV(b))) continue;
+
+    // PUSH EDGE (if the ring is full, the level stays unrecorded so the
+    // next PCINT or Timer1 sample reports the change again)
+    uint8_t next = (edge_head + 1) & (EDGE_RING_SIZE - 1);
+    if(next == edge_tail) return;
+    edge_ring[edge_head].time = now;
+    edge_ring[edge_head].button = b;
+    edge_ring[edge_head].level = levels & _BV(b);
+#ifdef LATENCY_TRACE
+    edge_ring[edge_head].us = micros();
+#endif
+    edge_head = next;
+    edge_levels ^= _BV(b);
+  }
+}
+
+ISR(PCINT0_vect) { captureButtons(); }
+ISR(PCINT1_vect) { captureButtons(); }
+ISR(PCINT2_vect) { captureButtons(); }
+
+/*
+ * @brief Enables the pin-change interrupt of a button pin, if it has one
+ * @param pin -> Button pin number
+*/
+void enableButtonInterrupt(uint8_t pin) {
+  volatile uint8_t* pcicr = digitalPinToPCICR(pin);
+  if(!pcicr) return; // sampled from the Timer1 ISR instead
+  *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  *pcicr |= _BV(digitalPinToPCICRbit(pin));
+}
+
+/*
+ * @brief Accepts p's captured level once it outlasts the lockout window
+ * @param p   -> Player to update
+ * @param now -> Time of the captured edge, or current time
+ * The first edge of a bounce burst starts a lockout of
+ * DEBOUNCE_LOCKOUT_MS. The new level is only accepted if it is still
+ * there when the lockout ends (a glitch shorter than that is dropped),
+ * and is then timed from the first edge
+*/
+void settleButton(Player& p, unsigned long now) {
+  if(!p.settling) {
+    if(p.raw_level != p.button_state) {
+      p.settling = true;
+      p.lock_start = now;
+    }
+  } else if(now - p.lock_start >= DEBOUNCE_LOCKOUT_MS) {
+    p.settling = false;
+    if(p.raw_level != p.button_state) {
+      p.button_state = p.raw_level;
+      now = p.lock_start;
+    }
+  }
+  handle_button(p, buttonEvent(p, now));
+}
+
+/*
+ * @brief Handles all captured button edges, oldest first
+*/
+void drainButtonEdges() {
+  while(edge_tail != edge_head) {
+    volatile ButtonEdge& e = edge_ring[edge_tail];
+    Player& p = players[e.button];
+    unsigned long time = e.time;
+    settleButton(p, time); // a lockout ending first sees the level it held
+    p.raw_level = e.level;
+#ifdef LATENCY_TRACE
+    if(!p.settling) p.edge_us = e.us; // edge that starts the lockout
+#endif
+    edge_tail = (edge_tail + 1) & (EDGE_RING_SIZE - 1); // frees the slot
+    settleButton(p, time);
+  }
+
+  // RESYNC AFTER LOCKOUT & CHECK HOLDS
+  unsigned long now = millis();
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) settleButton(players[i], now);
+}
+#endif
+
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+/*
+ * @brief Lights the next digit of the front frame
+ * Every digit gets exactly one Timer1 slot per scan, blank or not, so
+ * on-time (and brightness) is equal. Frames are only swapped between
+ * scans, and segments only change while all digits are dark
+*/
+void scanNextDigit(){
+  MuxEnables::write(mux_digit, MUX_ENABLE_OFF);
+
+  // NEXT DIGIT, NEW FRAME AT START OF SCAN
+  if(++mux_digit >= FRAME_DIGITS){
+    mux_digit = 0;
+    if(frame_swap){
+      frame_front ^= 1;
+      frame_swap = false;
+    }
+  }
+
+  int8_t num = frames[frame_front][mux_digit];
+  MuxSegments::write(digitGlyph(num));
+  MuxEnables::write(mux_digit, MUX_ENABLE_ON);
+
+#ifdef LATENCY_TRACE
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    if(mux_digit == AllPlayers::onesDigit(i)) traceShown(players[i], num);
+  }
+#endif
+}
+#endif
+
+#if DISPLAY_REFRESH_ISR
+/*
+ * @brief Refreshes the display from the front frame
+ * Also samples buttons that have no pin-change interrupt
+*/
+ISR(TIMER1_COMPA_vect){
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+  scanNextDigit();
+#else
+  // TAKE PENDING FRAME
+  bool force = false;
+  if(frame_swap){
+    frame_front ^= 1;
+    frame_swap = false;
+    force = frame_force;
+  }
+
+  const volatile int8_t* front = frames[frame_front];
+  for(uint8_t d = 0; d < FRAME_DIGITS; d++) displayDigit(d, front[d]);
+  displayFlush(force);
+
+#ifdef LATENCY_TRACE
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    traceShown(players[i], front[AllPlayers::onesDigit(i)]);
+  }
+#endif
+#endif
+
+#if BUTTON_CAPTURE_IRQ
+  captureButtons();
+#endif
+}
+#endif
+
+#ifdef STATS_SERIAL
+/*
+ * @brief Dumps the stats when STATS_DUMP_CMD arrives over Serial, the
+ * event log on LOG_DUMP_CMD
+*/
+void serviceStats() {
+  while(Serial.available()) {
+    int cmd = Serial.read();
+#ifdef EVENT_LOG
+    if(cmd == LOG_DUMP_CMD) logDump();
+#endif
+    if(cmd != STATS_DUMP_CMD) continue;
+#ifdef LOOP_STATS
+    histDump(loop_hist, "loop");
+#endif
+#ifdef LATENCY_TRACE
+    // COPY OUT OF THE REFRESH ISR's REACH
+    Histogram latency;
+    noInterrupts();
+    latency = latency_hist;
+    interrupts();
+    histDump(latency, "latency");
+#endif
+  }
+}
+#endif
+
+/*===================================================================*\   
+|                                SETUP()                              |
+\*===================================================================*/
+
+void setup() {
+#ifdef WATCHDOG_RESET
+  // STOP THE WATCHDOG A HARD RESET LEFT RUNNING
+  MCUSR &= ~_BV(WDRF);
+  wdt_disable();
+#endif
+
+  // INITIALIZE GLOBALS
+  winner_found = false;
+  winner = 0;
+  memset(games_won, 0, sizeof(games_won));
+  games_played = 0;
+  match_over = false;
+  show_standings = false;
+  game_over_start = 0;
+  last_refresh = millis() - FULL_REFRESH_MS; // full refresh on first loop
+  blink_phase = BLINK_SCORE;
+  blink_start = 0;
+  last_sample = 0;
+#ifdef RULES_FROM_EEPROM
+  loadRules();
+#endif
+
+  // =========== Players ============ //
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    players[i] = {
+      .score = 0,
+      .digits = {0},
+      .num_digits = AllPlayers::digits(i),
+      .dirty = 0xFF, // every digit rendered on first loop
+      .start = 0,
+      .button_state = LOW,
+      .prev_button_state = LOW
+    };
+#ifdef LATENCY_TRACE
+    players[i].trace_digit = -1; // nothing traced yet
+#endif
+  }
+
+#ifdef LATENCY_TRACE
+  histClear(latency_hist);
+#endif
+
+#ifdef SCORE_JOURNAL
+  startJournal();
+#endif
+
+#ifdef RESUME_GAME
+  // RESUME GAME IN PROGRESS (RAM survives resets, the journal power cuts)
+  if(!resumeGame()) {
+#ifdef SCORE_JOURNAL
+    replayJournal();
+#endif
+    saveGame();
+  }
+#elif defined(SCORE_JOURNAL)
+  // REPLAY GAME IN PROGRESS
+  replayJournal();
+#endif
+
+  // SET OUTPUT PINS
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+  MuxSegments::begin();
+  MuxEnables::begin();
+  mux_digit = FRAME_DIGITS - 1; // first tick starts a scan
+#elif DISPLAY_BACKEND == DISPLAY_SHIFT_595
+  startShiftRegisters();
+#elif DISPLAY_BACKEND == DISPLAY_MAX7219
+  startMax7219();
+#else
+  StaticDigits::begin();
+#endif
+
+  // SET INPUT PINS
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) pinMode(AllPlayers::button(i), INPUT);
+
+#if BUTTON_CAPTURE_IRQ
+  // START BUTTON CAPTURE (P2_BUTTON has no PCINT, Timer1 samples it)
+  edge_head = 0;
+  edge_tail = 0;
+  edge_levels = 0;
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    enableButtonInterrupt(AllPlayers::button(i));
+  }
+#endif
+
+#if DISPLAY_REFRESH_ISR
+  // START DISPLAY REFRESH (blank until the first frame is committed)
+  for(int i = 0; i < FRAME_DIGITS; i++){
+    frames[0][i] = -1;
+    frames[1][i] = -1;
+  }
+  frame_front = 0;
+  frame_swap = false;
+  frame_dirty = false;
+  frame_full = false;
+  frame_force = false;
+  startRefreshTimer();
+#endif
+
+#ifdef STATS_SERIAL
+  Serial.begin(SERIAL_BAUD);
+#endif
+#ifdef LOOP_STATS
+  histClear(loop_hist);
+  loop_last_us = micros();
+#endif
+#ifdef EVENT_LOG
+  logClear();
+#endif
+}
+
+/*===================================================================*\   
+|                                 LOOP()                              |
 \*===================================================================*/
 
 void loop() {
-  // DISPLAY SCORES
-  displayFirstDigit(p1, p1.d1_num);
-  displaySecondDigit(p1, p1.d2_num);
-  displayFirstDigit(p2, p2.d1_num);
-  displaySecondDigit(p2, p2.d2_num);
+#ifdef LOOP_STATS
+  // TIME SINCE LAST PASS
+  unsigned long loop_us = micros();
+  histAdd(loop_hist, loop_us - loop_last_us);
+  loop_last_us = loop_us;
+#endif
+#ifdef STATS_SERIAL
+  serviceStats();
+#endif
+
+  // DISPLAY SCORES (changed digits only, all digits periodically)
+  bool full_refresh = millis() - last_refresh >= FULL_REFRESH_MS;
+  if(full_refresh) last_refresh = millis();
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+    renderScore(i, isBlanked(i), full_refresh);
+  }
+#if DISPLAY_REFRESH_ISR
+  commitFrame(full_refresh);
+#else
+  displayFlush(full_refresh);
+#endif
 
   // HANDLE BUTTON INPUTS
-  handle_button(p1);
-  handle_button(p2);
-  
-  // CHECK FOR WINNING CONDITIONS
-  if(!winner_found) {
-     // COMBINE DIGIT NUMS INTO SCORE
-     uint8_t p1_score = p1.d1_num * NUM_DIGITS + p1.d2_num;
-     uint8_t p2_score = p2.d1_num * NUM_DIGITS + p2.d2_num;
-
-     // CHECK WIN BY 2
-     if(p1_score >= UP_TO_SCORE && p1_score > (p2_score + 1)) {
-       winner_found = true;
-       p1_is_winner = true;
-     } else if(p2_score >= UP_TO_SCORE && p2_score > (p1_score + 1)) {
-       winner_found = true;
-     }
-   } else if(p1_is_winner){
-     // BLINK PLAYER 1's SCORE
-     blinkWinner(p1);
-   } else {
-     // BLINK PLAYER 2's SCORE
-     blinkWinner(p2);
-   }
+#if BUTTON_CAPTURE_IRQ
+  drainButtonEdges();
+#else
+  // sampled every DEBOUNCE_SAMPLE_MS
+  if(millis() - last_sample >= DEBOUNCE_SAMPLE_MS) {
+    last_sample = millis();
+    uint8_t levels = AllPlayers::readButtons();
+    for(uint8_t i = 0; i < NUM_PLAYERS; i++){
+      handle_button(players[i], debounceButton(players[i], levels & _BV(i)));
+    }
+  }
+#endif
+
+  // BLINK WINNER's SCORE, THEN ON TO THE NEXT GAME UNTIL THE MATCH IS WON
+  // (winning conditions are checked on score change)
+  if(winner_found) {
+    if(!show_standings) blinkWinner();
+    if(!match_over) advanceMatch();
+  }
 }
 // EOF
@@ -0,0 +1,202 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ Arduino.h
+// Description---------+ Host stand-in for the Arduino core so scorer.cpp
+// --------------------- builds and runs natively on Linux
+// Features------------+ Mega port registers, virtual clock, Timer1 compare
+// --------------------- and PCINT0 emulation, SREG/cli/sei, Serial, SPI
+// --------------------- into a 74HC595 chain, EEPROM kept across reboots
+// --------------------- with timed EEPROM ready interrupt writes, watchdog
+// --------------------- resets
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/*===================================================================*\   
+|                         PREPROCESSOR MACROS                         |
+\*===================================================================*/
+
+// Board
+#define F_CPU 16000000UL     // Simulated clock (Mega 2560)
+#define SIM_NUM_PINS 70      // Digital pins 0-69
+#define SIM_NUM_PORTS 13     // Core port numbers 0 (none) -> 12
+#define E2END 0xFFF          // Last EEPROM address (4 KB)
+
+// Ports (core numbering)
+#define PA 1
+#define PB 2
+#define PC 3
+#define PD 4
+#define PE 5
+#define PF 6
+#define PG 7
+#define PH 8
+#define PJ 10
+#define PK 11
+#define PL 12
+
+// Pin Levels & Modes
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Registers & Interrupts
+#define _BV(bit) (1 << (bit))
+#define ISR(vector) extern "C" void vector()
+#define SREG_I 7
+#define NOT_A_PORT 0
+
+// Timer1 bits (ATmega2560 layout)
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define OCIE1A 1
+
+// Pin change interrupt bits
+#define PCIE0 0
+
+// EEPROM control bits (EECR)
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+#define SIM_EEPROM_WRITE_US 3400 // Erase & write time of 1 byte
+
+// Reset cause bits (MCUSR)
+#define WDRF 3
+
+// SPI bits
+#define SPI2X 0
+#define MSTR 4
+#define SPE 6
+#define SPIF 7
+#define SIM_SHIFT_CHAIN 16   // 74HC595s chained on MOSI
+#define SIM_MAX7219_REGS 16  // MAX7219 register addresses
+
+// Flash data & strings live in ordinary memory on the host
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+#define F(str) (str)
+
+/*===================================================================*\   
+|                           TYPE DEFINITIONS                          |
+\*===================================================================*/
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/*
+ * SPI data register: a write clocks the byte into the simulated 74HC595
+ * chain and MAX7219, and completes at once (SPIF set)
+ */
+class SimSpiData {
+public:
+  SimSpiData& operator=(uint8_t val);
+  operator uint8_t() const;
+};
+
+/*
+ * Serial port: output goes to stdout, input is queued by simSerialInput()
+ */
+class SimSerial {
+public:
+  void begin(unsigned long baud);
+  int available();
+  int read();
+  size_t write(uint8_t c);
+  size_t print(const char* str);
+  size_t print(char c);
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(int n) { return print((long)n); }
+  size_t print(unsigned int n) { return print((unsigned long)n); }
+  size_t println() { return print("\r\n"); }
+  template<typename T> size_t println(T val) { return print(val) + println(); }
+};
+
+/*===================================================================*\   
+|                           GLOBAL VARIABLES                          |
+\*===================================================================*/
+
+// Status & Timer1 registers
+extern volatile uint8_t SREG;
+extern volatile uint8_t MCUSR;
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint16_t OCR1A;
+extern volatile uint8_t TIMSK1;
+
+extern SimSerial Serial;
+
+// EEPROM registers
+extern volatile uint8_t EECR;
+extern volatile uint8_t EEDR;
+extern volatile uint16_t EEAR;
+
+// SPI registers
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+extern SimSpiData SPDR;
+
+// Pin change registers
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+
+/*===================================================================*\   
+|                              FUNCTIONS                              |
+\*===================================================================*/
+
+// Arduino core
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void cli();
+void sei();
+inline void noInterrupts() { cli(); }
+inline void interrupts() { sei(); }
+
+/*
+ * Pins map onto the Mega 2560's ports, so direct register access in
+ * scorer.cpp lands on the same state as digitalWrite/digitalRead
+ */
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+volatile uint8_t* portOutputRegister(uint8_t port);
+volatile uint8_t* portInputRegister(uint8_t port);
+
+// Pin change interrupts, PCINT0 group (pins 10-13 & 50-53) only
+volatile uint8_t* digitalPinToPCICR(uint8_t pin);
+uint8_t digitalPinToPCICRbit(uint8_t pin);
+volatile uint8_t* digitalPinToPCMSK(uint8_t pin);
+uint8_t digitalPinToPCMSKbit(uint8_t pin);
+
+// Simulation control
+void simBegin();
+void simAdvance(unsigned long us);
+void simSetPin(uint8_t pin, uint8_t val);
+void simSerialInput(const char* str);
+uint8_t simShiftByte(uint8_t pos);
+uint8_t simMax7219Reg(uint8_t reg);
+void simEepromWrite(uint16_t addr, uint8_t val);
+void simOnReset(jmp_buf* env);
+uint8_t simGetPin(uint8_t pin);
+unsigned long long simMicros();
+
+#endif
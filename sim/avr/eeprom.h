@@ -0,0 +1,22 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ avr/eeprom.h
+// Description---------+ Host stand-in for avr-libc's EEPROM routines,
+// --------------------- backed by the simulated EEPROM in hal.cpp
+
+#ifndef SIM_AVR_EEPROM_H
+#define SIM_AVR_EEPROM_H
+
+#include <stdint.h>
+
+/*===================================================================*\   
+|                              FUNCTIONS                              |
+\*===================================================================*/
+
+uint8_t eeprom_read_byte(const uint8_t* addr);
+void eeprom_write_byte(uint8_t* addr, uint8_t val);
+void eeprom_update_byte(uint8_t* addr, uint8_t val);
+
+#endif
@@ -0,0 +1,36 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ avr/wdt.h
+// Description---------+ Host stand-in for avr-libc's watchdog routines,
+// --------------------- backed by the simulated watchdog in hal.cpp
+
+#ifndef SIM_AVR_WDT_H
+#define SIM_AVR_WDT_H
+
+#include <stdint.h>
+
+/*===================================================================*\   
+|                         PREPROCESSOR MACROS                         |
+\*===================================================================*/
+
+// Timeouts, 15 ms << value
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+
+/*===================================================================*\   
+|                              FUNCTIONS                              |
+\*===================================================================*/
+
+void wdt_enable(uint8_t timeout);
+void wdt_disable();
+void wdt_reset();
+
+#endif
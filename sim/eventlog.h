@@ -0,0 +1,101 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ eventlog.h
+// Description---------+ Reads event log dumps (LOG_DUMP_CMD) back out of
+// --------------------- a Serial capture for the host tools, include
+// --------------------- after scorer.cpp (LOG_* event format)
+// Features------------+ Dump parsing, event decoding with absolute times
+
+#ifndef SIM_EVENTLOG_H
+#define SIM_EVENTLOG_H
+
+#include <stdio.h>
+
+/*===================================================================*\   
+|                         PREPROCESSOR MACROS                         |
+\*===================================================================*/
+
+#define LOG_LINE_SIZE 256    // Longest capture line read
+
+/*===================================================================*\   
+|                           TYPE DEFINITIONS                          |
+\*===================================================================*/
+
+/*
+ * LogDump type holds one dumped log, oldest event first
+ */
+typedef struct{
+  unsigned long t0;              // Time the first event counts from, in ms
+  size_t n;                      // Bytes read
+  uint8_t bytes[EVENT_LOG_SIZE]; // Dumped bytes
+} LogDump;
+
+/*
+ * LogEvent type is one decoded event
+ */
+typedef struct{
+  uint8_t type;     // LOG_* event type
+  uint8_t player;   // Player index
+  unsigned long ms; // Time of the event
+} LogEvent;
+
+/*===================================================================*\   
+                             FUNCTIONS                                |
+\*===================================================================*/
+
+/*
+ * @brief Reads the next log dump out of a capture, skipping other lines
+ * @param in   -> Capture to read
+ * @param dump -> Filled with the dump
+ * Returns FALSE once the capture holds no more dumps
+*/
+static bool readLogDump(FILE* in, LogDump& dump) {
+  char line[LOG_LINE_SIZE];
+  unsigned n;
+  for(;;) {
+    if(!fgets(line, sizeof(line), in)) return false;
+    if(sscanf(line, "log t0=%lu n=%u", &dump.t0, &n) == 2 && n <= EVENT_LOG_SIZE) break;
+  }
+
+  // HEX BYTES FOLLOW, 16 PER LINE
+  dump.n = 0;
+  while(dump.n < n && fgets(line, sizeof(line), in)) {
+    char* pos = line;
+    unsigned byte;
+    int used;
+    while(dump.n < n && sscanf(pos, "%2x%n", &byte, &used) == 1) {
+      dump.bytes[dump.n++] = byte;
+      pos += used;
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Decodes the next event of a dump, skipping idle padding
+ * @param dump -> Dump to decode
+ * @param pos  -> Byte of the next event's header, advanced past it
+ * @param e    -> Filled with the event, e.ms must start out as dump.t0
+ * Returns FALSE at the end of the dump (pos < dump.n if cut short)
+*/
+static bool nextLogEvent(const LogDump& dump, size_t& pos, LogEvent& e) {
+  while(pos < dump.n) {
+    uint8_t header = dump.bytes[pos];
+    if(pos + LOG_SIZE(header) > dump.n) return false;
+
+    // TICKS SINCE THE PREVIOUS EVENT, LSB FIRST
+    unsigned long ticks = 0;
+    for(int b = LOG_DT_BYTES(header); b > 0; b--) ticks = ticks << 8 | dump.bytes[pos + b];
+    e.ms += ticks * LOG_TICK_MS;
+    pos += LOG_SIZE(header);
+
+    e.type = LOG_TYPE(header);
+    e.player = LOG_PLAYER(header);
+    if(e.type != LOG_IDLE) return true;
+  }
+  return false;
+}
+
+#endif
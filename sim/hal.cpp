@@ -0,0 +1,412 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ hal.cpp
+// Description---------+ Simulated HAL behind sim/Arduino.h
+// Features------------+ Virtual microsecond clock, pin level/mode arrays,
+// --------------------- Timer1 compare A and PCINT0 interrupt delivery,
+// --------------------- EEPROM that survives simBegin() with EEPROM ready
+// --------------------- interrupt writes, watchdog reset
+
+#include "Arduino.h"
+#include "avr/eeprom.h"
+#include "avr/wdt.h"
+
+#include <stdio.h>
+
+/*===================================================================*\   
+|                         PREPROCESSOR MACROS                         |
+\*===================================================================*/
+
+#define TIMER1_CLOCK_MASK 0x07 // CS12:CS10
+#define SERIAL_RX_SIZE 64      // Serial input queue size
+
+/*===================================================================*\   
+|                           GLOBAL VARIABLES                          |
+\*===================================================================*/
+
+volatile uint8_t SREG;
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint16_t OCR1A;
+volatile uint8_t TIMSK1;
+volatile uint8_t PCICR;
+volatile uint8_t PCMSK0;
+volatile uint8_t PCMSK1;
+volatile uint8_t PCMSK2;
+volatile uint8_t MCUSR;
+volatile uint8_t SPCR;
+volatile uint8_t SPSR;
+SimSpiData SPDR;
+volatile uint8_t EECR;
+volatile uint8_t EEDR;
+volatile uint16_t EEAR;
+
+/*
+ * Mega 2560 digital pin -> port (high nibble) & bit (low nibble), as in
+ * the core's pins_arduino.h
+*/
+#define PIN_MAP(port, bit) ((port) << 4 | (bit))
+static const uint8_t PIN_MAP[SIM_NUM_PINS] = {
+  PIN_MAP(PE, 0), PIN_MAP(PE, 1), PIN_MAP(PE, 4), PIN_MAP(PE, 5), PIN_MAP(PG, 5),
+  PIN_MAP(PE, 3), PIN_MAP(PH, 3), PIN_MAP(PH, 4), PIN_MAP(PH, 5), PIN_MAP(PH, 6),
+  PIN_MAP(PB, 4), PIN_MAP(PB, 5), PIN_MAP(PB, 6), PIN_MAP(PB, 7), PIN_MAP(PJ, 1),
+  PIN_MAP(PJ, 0), PIN_MAP(PH, 1), PIN_MAP(PH, 0), PIN_MAP(PD, 3), PIN_MAP(PD, 2),
+  PIN_MAP(PD, 1), PIN_MAP(PD, 0), PIN_MAP(PA, 0), PIN_MAP(PA, 1), PIN_MAP(PA, 2),
+  PIN_MAP(PA, 3), PIN_MAP(PA, 4), PIN_MAP(PA, 5), PIN_MAP(PA, 6), PIN_MAP(PA, 7),
+  PIN_MAP(PC, 7), PIN_MAP(PC, 6), PIN_MAP(PC, 5), PIN_MAP(PC, 4), PIN_MAP(PC, 3),
+  PIN_MAP(PC, 2), PIN_MAP(PC, 1), PIN_MAP(PC, 0), PIN_MAP(PD, 7), PIN_MAP(PG, 2),
+  PIN_MAP(PG, 1), PIN_MAP(PG, 0), PIN_MAP(PL, 7), PIN_MAP(PL, 6), PIN_MAP(PL, 5),
+  PIN_MAP(PL, 4), PIN_MAP(PL, 3), PIN_MAP(PL, 2), PIN_MAP(PL, 1), PIN_MAP(PL, 0),
+  PIN_MAP(PB, 3), PIN_MAP(PB, 2), PIN_MAP(PB, 1), PIN_MAP(PB, 0), PIN_MAP(PF, 0),
+  PIN_MAP(PF, 1), PIN_MAP(PF, 2), PIN_MAP(PF, 3), PIN_MAP(PF, 4), PIN_MAP(PF, 5),
+  PIN_MAP(PF, 6), PIN_MAP(PF, 7), PIN_MAP(PK, 0), PIN_MAP(PK, 1), PIN_MAP(PK, 2),
+  PIN_MAP(PK, 3), PIN_MAP(PK, 4), PIN_MAP(PK, 5), PIN_MAP(PK, 6), PIN_MAP(PK, 7)
+};
+
+volatile uint8_t port_out[SIM_NUM_PORTS]; // PORTx, driven output levels
+volatile uint8_t port_in[SIM_NUM_PORTS];  // PINx, externally driven levels
+uint8_t port_ddr[SIM_NUM_PORTS];          // DDRx, 1 = output
+
+uint8_t shift_chain[SIM_SHIFT_CHAIN]; // 595 contents, 0 = nearest MOSI
+uint8_t spi_last;                     // Last byte written to SPDR
+uint8_t spi_count;                    // Bytes sent since boot
+uint8_t max7219_regs[SIM_MAX7219_REGS]; // MAX7219 registers
+unsigned long long wdt_due;           // Watchdog expiry (0 = stopped)
+unsigned long wdt_period;             // Watchdog timeout in us
+jmp_buf* wdt_reset_env;               // Unwound to on a watchdog reset
+uint8_t eeprom[E2END + 1];            // EEPROM contents
+bool eeprom_formatted;                // FALSE = not yet erased to 0xFF
+unsigned long long eeprom_due;        // Register write completion (0 = idle)
+uint16_t eeprom_addr;                 // Address of the register write
+uint8_t eeprom_data;                  // Byte of the register write
+
+SimSerial Serial;
+char serial_rx[SERIAL_RX_SIZE]; // Queued Serial input
+size_t serial_rx_len;           // Bytes queued
+size_t serial_rx_pos;           // Next byte to read
+
+unsigned long long now_us;     // Virtual clock
+unsigned long long timer1_due; // Next Timer1 compare match (0 = stopped)
+
+// Interrupt vectors, only present when the sketch defines them
+extern "C" void TIMER1_COMPA_vect() __attribute__((weak));
+extern "C" void PCINT0_vect() __attribute__((weak));
+extern "C" void EE_READY_vect() __attribute__((weak));
+
+/*===================================================================*\   
+                             FUNCTIONS                                |
+\*===================================================================*/
+
+/*
+ * @brief Returns the Timer1 compare period in microseconds (0 = stopped)
+*/
+static unsigned long timer1Period() {
+  static const unsigned int PRESCALE[] = {0, 1, 8, 64, 256, 1024, 0, 0};
+  unsigned int prescale = PRESCALE[TCCR1B & TIMER1_CLOCK_MASK];
+  if(!prescale || !(TIMSK1 & _BV(OCIE1A)) || !TIMER1_COMPA_vect) return 0;
+  return (unsigned long)(OCR1A + 1UL) * prescale / (F_CPU / 1000000UL);
+}
+
+/*
+ * @brief Runs an interrupt vector with interrupts masked, as on AVR
+*/
+static void runISR(void (*vector)()) {
+  uint8_t sreg = SREG;
+  SREG &= ~_BV(SREG_I);
+  vector();
+  SREG = sreg;
+}
+
+/*
+ * @brief PCINT0 group bit of a pin (-1 = pin has no pin change IRQ)
+*/
+static int pcint0Bit(uint8_t pin) {
+  if(pin >= SIM_NUM_PINS || digitalPinToPort(pin) != PB) return -1;
+  return PIN_MAP[pin] & 0x0F; // PCINT0 -> 7 are PB0 -> PB7
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if(pin >= SIM_NUM_PINS) return;
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  if(mode == OUTPUT) {
+    port_ddr[port] |= mask;
+  } else {
+    port_ddr[port] &= ~mask;
+  }
+  if(mode == INPUT_PULLUP) {
+    port_out[port] |= mask;
+    port_in[port] |= mask; // nothing pulls it low until simSetPin()
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if(pin >= SIM_NUM_PINS) return;
+  if(val) {
+    port_out[digitalPinToPort(pin)] |= digitalPinToBitMask(pin);
+  } else {
+    port_out[digitalPinToPort(pin)] &= ~digitalPinToBitMask(pin);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if(pin >= SIM_NUM_PINS) return LOW;
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  uint8_t levels = (port_ddr[port] & mask) ? port_out[port] : port_in[port];
+  return (levels & mask) ? HIGH : LOW;
+}
+
+unsigned long millis() { return (unsigned long)(now_us / 1000); }
+unsigned long micros() { return (unsigned long)now_us; }
+
+/*
+ * @brief Skips the virtual clock ahead instead of sleeping, interrupts
+ * due on the way still run. A blocking wait costs no wall clock time
+*/
+void delay(unsigned long ms) {
+  simAdvance(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvance(us);
+}
+
+void cli() { SREG &= ~_BV(SREG_I); }
+void sei() { SREG |= _BV(SREG_I); }
+
+uint8_t digitalPinToPort(uint8_t pin) {
+  return pin < SIM_NUM_PINS ? PIN_MAP[pin] >> 4 : NOT_A_PORT;
+}
+uint8_t digitalPinToBitMask(uint8_t pin) {
+  return pin < SIM_NUM_PINS ? 1 << (PIN_MAP[pin] & 0x0F) : 0;
+}
+volatile uint8_t* portOutputRegister(uint8_t port) { return &port_out[port]; }
+volatile uint8_t* portInputRegister(uint8_t port) { return &port_in[port]; }
+
+volatile uint8_t* digitalPinToPCICR(uint8_t pin) {
+  return pcint0Bit(pin) < 0 ? NULL : &PCICR;
+}
+uint8_t digitalPinToPCICRbit(uint8_t pin) { (void)pin; return PCIE0; }
+volatile uint8_t* digitalPinToPCMSK(uint8_t pin) {
+  return pcint0Bit(pin) < 0 ? NULL : &PCMSK0;
+}
+uint8_t digitalPinToPCMSKbit(uint8_t pin) { return pcint0Bit(pin); }
+
+void SimSerial::begin(unsigned long baud) { (void)baud; }
+int SimSerial::available() { return (int)(serial_rx_len - serial_rx_pos); }
+int SimSerial::read() {
+  return serial_rx_pos < serial_rx_len ? serial_rx[serial_rx_pos++] : -1;
+}
+size_t SimSerial::write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+size_t SimSerial::print(const char* str) { return fputs(str, stdout) < 0 ? 0 : strlen(str); }
+size_t SimSerial::print(char c) { return write(c); }
+size_t SimSerial::print(long n) { return printf("%ld", n); }
+size_t SimSerial::print(unsigned long n) { return printf("%lu", n); }
+
+SimSpiData& SimSpiData::operator=(uint8_t val) {
+  spi_last = val;
+  if(!(SPCR & _BV(SPE))) return *this;
+  memmove(shift_chain + 1, shift_chain, SIM_SHIFT_CHAIN - 1);
+  shift_chain[0] = val;
+
+  // MAX7219 LOAD framing is not modelled, every 2nd byte completes a word
+  if(++spi_count % 2 == 0) {
+    max7219_regs[shift_chain[1] & 0x0F] = shift_chain[0];
+  }
+  SPSR |= _BV(SPIF);
+  return *this;
+}
+SimSpiData::operator uint8_t() const { return spi_last; }
+
+/*
+ * @brief Reads a 595's shift stage (what it outputs once latched)
+ * @param pos -> Position in the chain, 0 = nearest MOSI
+*/
+uint8_t simShiftByte(uint8_t pos) {
+  return pos < SIM_SHIFT_CHAIN ? shift_chain[pos] : 0;
+}
+
+/*
+ * @brief Reads a MAX7219 register
+ * @param reg -> Register address (0x01 -> 0x08 = digits)
+*/
+uint8_t simMax7219Reg(uint8_t reg) {
+  return reg < SIM_MAX7219_REGS ? max7219_regs[reg] : 0;
+}
+
+/*
+ * @brief Erases the EEPROM to 0xFF the first time it is touched
+*/
+static void eepromPowerUp() {
+  if(eeprom_formatted) return;
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  eeprom_formatted = true;
+}
+
+uint8_t eeprom_read_byte(const uint8_t* addr) {
+  eepromPowerUp();
+  return eeprom[(uintptr_t)addr & E2END];
+}
+
+void eeprom_write_byte(uint8_t* addr, uint8_t val) {
+  eepromPowerUp();
+  eeprom[(uintptr_t)addr & E2END] = val;
+}
+
+void eeprom_update_byte(uint8_t* addr, uint8_t val) {
+  if(eeprom_read_byte(addr) != val) eeprom_write_byte(addr, val);
+}
+
+/*
+ * @brief Runs the EEPROM ready interrupt while the EEPROM is idle, and
+ * starts the write it requests through EECR
+*/
+static void eepromService() {
+  if(!(EECR & _BV(EEPE)) && (EECR & _BV(EERIE)) && EE_READY_vect &&
+     (SREG & _BV(SREG_I))) {
+    runISR(EE_READY_vect);
+  }
+  if((EECR & _BV(EEPE)) && !eeprom_due) {
+    eeprom_due = now_us + SIM_EEPROM_WRITE_US;
+    eeprom_addr = EEAR & E2END;
+    eeprom_data = EEDR;
+    EECR &= ~_BV(EEMPE);
+  }
+}
+
+/*
+ * @brief Finishes the register write in progress
+*/
+static void eepromComplete() {
+  eeprom_write_byte((uint8_t*)(uintptr_t)eeprom_addr, eeprom_data);
+  eeprom_due = 0;
+  EECR &= ~_BV(EEPE);
+}
+
+void wdt_enable(uint8_t timeout) {
+  wdt_period = 15000UL << timeout;
+  wdt_due = now_us + wdt_period;
+}
+
+void wdt_disable() { wdt_due = 0; }
+
+void wdt_reset() {
+  if(wdt_due) wdt_due = now_us + wdt_period;
+}
+
+/*
+ * @brief Sets where a watchdog reset unwinds to, the harness reboots
+ * from there like the board's reset vector
+ * @param env -> setjmp() buffer in the harness
+*/
+void simOnReset(jmp_buf* env) {
+  wdt_reset_env = env;
+}
+
+/*
+ * @brief Writes an EEPROM byte from the harness (e.g. settings)
+ * @param addr -> EEPROM address
+ * @param val  -> Byte to store
+*/
+void simEepromWrite(uint16_t addr, uint8_t val) {
+  eeprom_write_byte((uint8_t*)(uintptr_t)addr, val);
+}
+
+/*
+ * @brief Queues bytes for the sketch to read from Serial
+ * @param str -> Bytes to queue (dropped once the queue is full)
+*/
+void simSerialInput(const char* str) {
+  if(serial_rx_pos == serial_rx_len) serial_rx_pos = serial_rx_len = 0;
+  while(*str && serial_rx_len < SERIAL_RX_SIZE) serial_rx[serial_rx_len++] = *str++;
+}
+
+/*
+ * @brief Powers up the simulated board: clock at 0, pins low & input,
+ * peripherals stopped, interrupts enabled (as after Arduino's init())
+*/
+void simBegin() {
+  memset((void*)port_out, 0, sizeof(port_out));
+  memset((void*)port_in, 0, sizeof(port_in));
+  memset(port_ddr, 0, sizeof(port_ddr));
+  TCCR1A = TCCR1B = TIMSK1 = 0;
+  OCR1A = 0;
+  PCICR = PCMSK0 = PCMSK1 = PCMSK2 = 0;
+  SPCR = SPSR = 0;
+  memset(shift_chain, 0, sizeof(shift_chain));
+  memset(max7219_regs, 0, sizeof(max7219_regs));
+  spi_count = 0;
+  EECR = EEDR = 0;
+  EEAR = 0;
+  eeprom_due = 0; // a write cut off by the power is lost
+  SREG = _BV(SREG_I);
+  now_us = 0;
+  timer1_due = 0;
+  serial_rx_len = serial_rx_pos = 0;
+}
+
+/*
+ * @brief Advances the virtual clock, firing Timer1 compare matches and
+ * EEPROM ready interrupts due on the way. Interrupts only ever run
+ * between calls into the sketch
+ * @param us -> Microseconds to advance
+*/
+void simAdvance(unsigned long us) {
+  unsigned long long end = now_us + us;
+  for(;;) {
+    eepromService();
+    unsigned long period = timer1Period();
+    if(!period) timer1_due = 0;
+    else if(!timer1_due) timer1_due = now_us + period; // timer just started
+
+    // NEXT EVENT: EEPROM WRITE DONE OR TIMER1 COMPARE MATCH
+    unsigned long long due = timer1_due;
+    if(eeprom_due && (!due || eeprom_due < due)) due = eeprom_due;
+    if(!due || due > end) break;
+
+    now_us = due;
+    if(due == eeprom_due) eepromComplete();
+    if(due == timer1_due) {
+      timer1_due += period;
+      if(SREG & _BV(SREG_I)) runISR(TIMER1_COMPA_vect);
+    }
+  }
+  now_us = end;
+
+  // WATCHDOG EXPIRED: RESET (abandons whatever the sketch was running)
+  if(wdt_due && now_us >= wdt_due && wdt_reset_env) {
+    wdt_due = 0;
+    MCUSR |= _BV(WDRF);
+    longjmp(*wdt_reset_env, 1);
+  }
+}
+
+/*
+ * @brief Drives an input pin from outside the board (buttons)
+ * @param pin -> Pin number
+ * @param val -> HIGH / LOW
+*/
+void simSetPin(uint8_t pin, uint8_t val) {
+  if(pin >= SIM_NUM_PINS) return;
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  uint8_t levels = val ? (port_in[port] | mask) : (port_in[port] & ~mask);
+  if(levels == port_in[port]) return;
+  port_in[port] = levels;
+
+  // PIN CHANGE INTERRUPT
+  int bit = pcint0Bit(pin);
+  if(bit >= 0 && (PCICR & _BV(PCIE0)) && (PCMSK0 & _BV(bit)) &&
+     PCINT0_vect && (SREG & _BV(SREG_I))) {
+    runISR(PCINT0_vect);
+  }
+}
+
+uint8_t simGetPin(uint8_t pin) {
+  if(pin >= SIM_NUM_PINS) return LOW;
+  return (port_out[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+unsigned long long simMicros() { return now_us; }
@@ -0,0 +1,77 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ logdecode.cpp
+// Description---------+ Host tool decoding the event log dumped by
+// --------------------- scorer.cpp (LOG_DUMP_CMD) into readable events
+// Features------------+ Reads a Serial capture on stdin, skips anything
+// --------------------- that is not a dump, prints each event with its
+// --------------------- time and the score each game ended on
+
+#include "Arduino.h"
+#include "../scorer.cpp" // LOG_* event format
+#include "eventlog.h"
+
+#include <stdio.h>
+
+/*===================================================================*\   
+|                           GLOBAL VARIABLES                          |
+\*===================================================================*/
+
+// Event names, indexed by LOG_* type
+const char* const EVENT_NAMES[] = {
+  "press", "release", "hold", "score", "win", "reset", "next game", "idle"
+};
+
+/*===================================================================*\   
+                             FUNCTIONS                                |
+\*===================================================================*/
+
+/*
+ * @brief Prints the score per player
+*/
+void printScore(const uint16_t* score) {
+  printf("           score");
+  for(int i = 0; i < NUM_PLAYERS; i++) printf(" %u", score[i]);
+  printf("\n");
+}
+
+/*
+ * @brief Decodes and prints one dumped log
+*/
+void decodeLog(const LogDump& dump) {
+  uint16_t score[NUM_PLAYERS] = {0};
+  size_t pos = 0;
+  LogEvent e;
+  e.ms = dump.t0;
+  while(nextLogEvent(dump, pos, e)) {
+    printf("%9.3f s  ", e.ms / 1000.0);
+    if(e.type <= LOG_WIN) printf("P%u ", e.player + 1);
+    printf("%s\n", EVENT_NAMES[e.type]);
+
+    // GAME ENDS
+    if(e.type == LOG_SCORE && e.player < NUM_PLAYERS) score[e.player]++;
+    if(e.type == LOG_WIN) printScore(score);
+    if(e.type == LOG_RESET || e.type == LOG_NEXT_GAME) memset(score, 0, sizeof(score));
+  }
+  if(pos < dump.n) printf("  truncated event at byte %zu\n", pos);
+  printScore(score);
+}
+
+/*===================================================================*\   
+|                                 MAIN                                |
+\*===================================================================*/
+
+int main() {
+  static LogDump dump;
+  int dumps = 0;
+
+  while(readLogDump(stdin, dump)) {
+    printf("log %d, %zu bytes\n", ++dumps, dump.n);
+    decodeLog(dump);
+  }
+
+  if(!dumps) fprintf(stderr, "no log dump found\n");
+  return dumps ? 0 : 1;
+}
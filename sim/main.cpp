@@ -0,0 +1,532 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ main.cpp
+// Description---------+ Host harness driving the unmodified setup()/loop()
+// --------------------- of scorer.cpp against the simulated HAL
+// Features------------+ Scripted button presses, segment pin decoding,
+// --------------------- watchdog reboots, power cuts, pass/fail summary,
+// --------------------- replay of recorded event logs (scorer_sim FILE..)
+
+#include "Arduino.h"
+#include "../scorer.cpp"
+#ifdef EVENT_LOG
+#include "eventlog.h"
+#endif
+
+#include <stdio.h>
+#include <time.h>
+
+/*===================================================================*\   
+|                         PREPROCESSOR MACROS                         |
+\*===================================================================*/
+
+#define SIM_LOOP_US 100      // Modeled duration of one loop() pass
+#define TAP_MS 80            // Length of a scripted button tap
+#define SHOWN_BLANK -1       // Decoded digit is blank
+#define SHOWN_INVALID -2     // Segment levels match no glyph
+#define REPLAY_LOOP_US 1000  // Modeled loop() pass while replaying a log
+#define REPLAY_SETTLE_MS 100 // Run after a log's last edge before checking
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+#define FRAME_US (1000000UL / MUX_SCAN_HZ)        // 1 scan of every digit
+#else
+#define FRAME_US (1000000UL / DISPLAY_REFRESH_HZ) // 1 refresh of every digit
+#endif
+#if BUTTON_CAPTURE_IRQ
+#define DEBOUNCE_US (DEBOUNCE_LOCKOUT_MS * 1000UL) // Level outlasts the lockout
+#else
+#define DEBOUNCE_US (DEBOUNCE_SAMPLES * DEBOUNCE_SAMPLE_MS * 1000UL) // Level held this long
+#endif
+#define LATENCY_MAX_US (DEBOUNCE_US + 4 * FRAME_US) // Release -> pins bound
+
+/*===================================================================*\   
+|                           GLOBAL VARIABLES                          |
+\*===================================================================*/
+
+int failures; // # of failed checks
+int reboots;  // # of board resets seen
+unsigned long long elapsed_us; // Virtual time run across reboots
+jmp_buf reset_env; // Where a watchdog reset lands
+
+/*===================================================================*\   
+                             FUNCTIONS                                |
+\*===================================================================*/
+
+/*
+ * @brief Powers up the board and runs setup()
+*/
+void boot() {
+  simBegin();
+  setup();
+}
+
+/*
+ * @brief Cuts the power and boots again, RAM comes back scrambled
+*/
+void powerCycle() {
+#ifdef RESUME_GAME
+  saved_game.crc ^= 0xFFFF;
+#endif
+  boot();
+}
+
+/*
+ * @brief Runs one loop() pass
+ * @param us -> Modeled duration of the pass
+ * An expired watchdog unwinds back here and reboots the board, as on
+ * hardware (time spent spinning before the reset is not counted)
+*/
+void step(unsigned long us) {
+  if(setjmp(reset_env)) {
+    reboots++;
+    boot();
+    return;
+  }
+  simOnReset(&reset_env);
+  loop();
+  simAdvance(us);
+  elapsed_us += us;
+}
+
+/*
+ * @brief Runs loop() for a length of virtual time
+ * @param ms -> Milliseconds to run for
+*/
+void run(unsigned long ms) {
+  for(unsigned long long t = 0; t < ms * 1000ULL; t += SIM_LOOP_US) step(SIM_LOOP_US);
+}
+
+/*
+ * @brief Presses and releases a button
+ * @param pin -> Button pin
+ * @param ms  -> Time the button is held down
+*/
+void press(uint8_t pin, unsigned long ms) {
+  simSetPin(pin, HIGH);
+  run(ms);
+  simSetPin(pin, LOW);
+  run(TAP_MS);
+}
+
+/*
+ * @brief Decodes a packed glyph back into its value
+*/
+int decodeGlyph(uint8_t glyph) {
+  if(glyph == GLYPH_BLANK) return SHOWN_BLANK;
+  for(int n = 0; n < NUM_DIGITS; n++) {
+    if(glyph == pgm_read_byte(&SEGMENT_GLYPHS[n])) return n;
+  }
+  return SHOWN_INVALID;
+}
+
+#if DISPLAY_BACKEND == DISPLAY_STATIC || DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+/*
+ * @brief Decodes the digit driven on a frame digit's segment pins
+ * @param digit -> Frame digit (ignored on the shared multiplexed bus)
+*/
+int decodeDigit(uint8_t digit) {
+  uint8_t glyph = GLYPH_BLANK;
+  for(int i = 0; i < SEVEN_SEGMENTS; i++) {
+#if DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+    uint8_t pin = MuxSegments::pin(i);
+#else
+    uint8_t pin = StaticDigits::pin(digit, i);
+#endif
+    if(simGetPin(pin) == ON) glyph |= SEG_BIT(i);
+  }
+  return decodeGlyph(glyph);
+}
+#endif
+
+/*
+ * @brief Decodes the value shown on a frame digit (P1 tens, P1 ones, ..)
+ * A multiplexed digit is read the next time the scan lights it, a 595
+ * digit only counts once latched (latch pin back HIGH), a MAX7219 digit
+ * only while the chip is configured and scanning it
+*/
+int shownDigit(uint8_t digit) {
+#if DISPLAY_BACKEND == DISPLAY_MAX7219
+  if(simMax7219Reg(MAX7219_SHUTDOWN) != 1 ||
+     simMax7219Reg(MAX7219_DISPLAY_TEST) != 0 ||
+     simMax7219Reg(MAX7219_DECODE_MODE) != 0 ||
+     simMax7219Reg(MAX7219_SCAN_LIMIT) < digit) return SHOWN_INVALID;
+  return decodeGlyph(simMax7219Reg(MAX7219_DIGIT0 + digit) << 1);
+#elif DISPLAY_BACKEND == DISPLAY_SHIFT_595
+  if(simGetPin(SHIFT_LATCH_PIN) != HIGH) return SHOWN_INVALID;
+  uint8_t levels = simShiftByte(FRAME_DIGITS - 1 - digit);
+  return decodeGlyph(GLYPH_HIGH(levels) & ~SEG_BIT(SEVEN_SEGMENTS));
+#elif DISPLAY_BACKEND == DISPLAY_MULTIPLEX
+  for(int tick = 0; tick <= FRAME_DIGITS; tick++) {
+    if(simGetPin(MuxEnables::pin(digit)) == MUX_ENABLE_ON) {
+      return decodeDigit(digit);
+    }
+    simAdvance(1000000UL / TIMER1_HZ);
+  }
+  return SHOWN_INVALID;
+#else
+  return decodeDigit(digit);
+#endif
+}
+
+/*
+ * @brief Decodes the number shown on a player's digits (-1 = blank)
+ * @param player   -> Player index (0 = Player 1)
+ * @param lead_off -> Leading digits may be blank
+*/
+int shownNumber(uint8_t player, bool lead_off) {
+  int score = SHOWN_BLANK;
+  uint8_t first = AllPlayers::firstDigit(player);
+  for(uint8_t d = first; d <= AllPlayers::onesDigit(player); d++) {
+    int num = shownDigit(d);
+    if(num == SHOWN_BLANK && score == SHOWN_BLANK) continue;
+    if(num < 0) return SHOWN_INVALID;
+    if(!lead_off && score == SHOWN_BLANK && d != first) return SHOWN_INVALID;
+    score = (score < 0 ? 0 : score * NUM_DIGITS) + num;
+  }
+  return score;
+}
+
+/*
+ * @brief Decodes a player's score, every digit lit or every digit blank
+*/
+int shownScore(uint8_t player) {
+  return shownNumber(player, false);
+}
+
+/*
+ * @brief Decodes a player's games won between games (leading blanks)
+*/
+int shownStandings(uint8_t player) {
+  return shownNumber(player, true);
+}
+
+#ifdef EVENT_LOG
+/*
+ * @brief Counts the events of a type & player in the event log
+*/
+int logCount(uint8_t type, uint8_t player) {
+  int count = 0;
+  for(uint16_t i = log_tail; i != log_head;
+      i = (i + LOG_SIZE(event_log[i])) & (EVENT_LOG_SIZE - 1)) {
+    uint8_t header = event_log[i];
+    if(LOG_TYPE(header) == type && LOG_PLAYER(header) == player) count++;
+  }
+  return count;
+}
+#endif
+
+/*
+ * @brief Records and reports a check result
+*/
+void check(bool ok, const char* what) {
+  printf("%s  %s\n", ok ? "PASS" : "FAIL", what);
+  if(!ok) failures++;
+}
+
+#ifdef EVENT_LOG
+/*
+ * @brief Replays a recorded log's button edges on a fresh board and
+ * checks the scores & winner it ends on against the recorded ones
+ * @param dump -> Recorded log (from power up, so from 0 - 0)
+ * @param name -> Label for the result
+ * Edges are driven at their recorded times, loop() runs in
+ * REPLAY_LOOP_US passes with no wall clock pacing
+*/
+void replayLog(const LogDump& dump, const char* name) {
+  powerCycle();
+  reset_game(); // drop any game the journal brought back
+#ifdef SCORE_JOURNAL
+  journalAppend(JOURNAL_RESET);
+#endif
+
+  // DRIVE EDGES, TALLY THE RECORDED OUTCOME
+  uint16_t score[NUM_PLAYERS] = {0};
+  bool won = false;
+  uint8_t won_by = 0;
+  size_t pos = 0;
+  LogEvent e;
+  e.ms = dump.t0;
+  while(nextLogEvent(dump, pos, e)) {
+    if(e.player >= NUM_PLAYERS) continue;
+    if(e.type == LOG_PRESS || e.type == LOG_RELEASE) {
+      while(simMicros() < e.ms * 1000ULL) step(REPLAY_LOOP_US);
+      simSetPin(AllPlayers::button(e.player), e.type == LOG_PRESS ? HIGH : LOW);
+    } else if(e.type == LOG_SCORE) {
+      score[e.player]++;
+    } else if(e.type == LOG_WIN) {
+      won = true;
+      won_by = e.player;
+    } else if(e.type == LOG_RESET || e.type == LOG_NEXT_GAME) {
+      memset(score, 0, sizeof(score));
+      won = false;
+    }
+  }
+  run(REPLAY_SETTLE_MS);
+
+  // COMPARE
+  bool ok = pos == dump.n && winner_found == won && (!won || winner == won_by);
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) ok = ok && players[i].score == score[i];
+  printf("%s  %s:", ok ? "PASS" : "FAIL", name);
+  for(uint8_t i = 0; i < NUM_PLAYERS; i++) printf(" %u", players[i].score);
+  if(winner_found) printf(", P%u won", winner + 1);
+  if(!ok) {
+    printf(" (recorded");
+    for(uint8_t i = 0; i < NUM_PLAYERS; i++) printf(" %u", score[i]);
+    if(won) printf(", P%u won", won_by + 1);
+    printf(pos == dump.n ? ")" : ", log cut short)");
+  }
+  printf("\n");
+  if(!ok) failures++;
+}
+
+/*
+ * @brief Replays every log dump in the given Serial captures
+ * @param count -> # of captures
+ * @param paths -> Capture file paths
+*/
+int replayCaptures(int count, char** paths) {
+  static LogDump dump;
+  int replayed = 0;
+  for(int i = 0; i < count; i++) {
+    FILE* in = fopen(paths[i], "r");
+    if(!in) {
+      printf("FAIL  %s: cannot open\n", paths[i]);
+      failures++;
+      continue;
+    }
+    for(int n = 1; readLogDump(in, dump); n++, replayed++) {
+      char name[LOG_LINE_SIZE];
+      snprintf(name, sizeof(name), "%s log %d", paths[i], n);
+      replayLog(dump, name);
+    }
+    fclose(in);
+  }
+
+  printf("%s: %d log(s) replayed, %d failure(s), %.1f s simulated\n",
+         failures ? "FAILED" : "OK", replayed, failures, elapsed_us / 1e6);
+  return failures ? 1 : 0;
+}
+#endif
+
+/*===================================================================*\   
+|                                 MAIN                                |
+\*===================================================================*/
+
+int main(int argc, char** argv) {
+#ifdef EVENT_LOG
+  // REPLAY MODE: scorer_sim CAPTURE...
+  if(argc > 1) return replayCaptures(argc - 1, argv + 1);
+#else
+  (void)argv;
+  if(argc > 1) {
+    printf("replay needs EVENT_LOG\n");
+    return 1;
+  }
+#endif
+
+  boot();
+  run(10);
+  check(shownScore(0) == 0 && shownScore(1) == 0, "boots showing 00 00");
+
+  // PLAY TO 21-19
+  for(int i = 0; i < 19; i++) press(P2_BUTTON, TAP_MS);
+  for(int i = 0; i < 20; i++) press(P1_BUTTON, TAP_MS);
+  run(10);
+  check(!winner_found, "no winner at 20-19");
+  check(shownScore(0) == 20 && shownScore(1) == 19, "shows 20 19");
+
+#ifdef LATENCY_TRACE
+  // RELEASE -> SEGMENT LATENCY
+  check(latency_hist.n == 39 && latency_hist.max <= LATENCY_MAX_US,
+        "all 39 releases reach the pins within a few refresh periods");
+#endif
+
+  press(P1_BUTTON, TAP_MS);
+  check(winner_found && winner == 0, "player 1 wins at 21-19");
+
+  press(P2_BUTTON, TAP_MS);
+  check(players[1].score == 19, "presses ignored after a win");
+
+#ifdef EVENT_LOG
+  check(logCount(LOG_SCORE, 0) == 21 && logCount(LOG_SCORE, 1) == 19 &&
+        logCount(LOG_WIN, 0) == 1 && logCount(LOG_PRESS, 1) == 20 &&
+        logCount(LOG_RELEASE, 1) == 20, "event log holds the game");
+
+  char log_cmd[] = { LOG_DUMP_CMD, 0 }; // for ./logdecode
+  simSerialInput(log_cmd);
+  run(1);
+#endif
+
+  // WINNING SCORE BLINKS WHILE THE LOSER STAYS LIT
+  bool seen_blank = false, seen_score = false, loser_lit = true;
+  for(int i = 0; i < 40; i++) {
+    run(50);
+    if(shownScore(0) == SHOWN_BLANK) seen_blank = true;
+    if(shownScore(0) == 21) seen_score = true;
+    if(shownScore(1) != 19) loser_lit = false;
+  }
+  check(seen_blank && seen_score && loser_lit, "winning score blinks");
+
+  // HOLD TO RESET
+  press(P2_BUTTON, BUTTON_HOLD_MS + 100);
+  run(10);
+  check(reboots == 0 && !winner_found, "3 s hold resets the game in place");
+  check(shownScore(0) == 0 && shownScore(1) == 0,
+        "reset shows 00 00 (ending the hold scores nothing)");
+
+  // SIMULTANEOUS PRESSES
+  simSetPin(P1_BUTTON, HIGH);
+  simSetPin(P2_BUTTON, HIGH);
+  run(TAP_MS);
+  simSetPin(P1_BUTTON, LOW);
+  simSetPin(P2_BUTTON, LOW);
+  run(TAP_MS);
+  check(shownScore(0) == 1 && shownScore(1) == 1,
+        "simultaneous presses both count");
+
+  // BOUNCY PRESS COUNTS ONCE
+  for(int i = 0; i < 5; i++) {
+    simSetPin(P1_BUTTON, HIGH);
+    run(1);
+    simSetPin(P1_BUTTON, LOW);
+    run(1);
+  }
+  simSetPin(P1_BUTTON, HIGH);
+  run(TAP_MS);
+  simSetPin(P1_BUTTON, LOW);
+  run(TAP_MS);
+  check(shownScore(0) == 2, "bouncing contact counts once");
+  int p1_score = 2; // P1 score from here on (the overflow check adds 1)
+
+  // SUB-MILLISECOND SPIKE IS NO PRESS
+  simSetPin(P1_BUTTON, HIGH);
+  simAdvance(1);
+  simSetPin(P1_BUTTON, LOW);
+  run(TAP_MS);
+  check(shownScore(0) == p1_score, "1 us spike on a button scores nothing");
+
+#if BUTTON_CAPTURE_IRQ
+  // EDGE RING OVERFLOW (loop() blocked through a bouncy press)
+  for(int i = 0; i < EDGE_RING_SIZE; i++) {
+    simSetPin(P1_BUTTON, HIGH);
+    simSetPin(P1_BUTTON, LOW);
+  }
+  simSetPin(P1_BUTTON, HIGH);
+  simAdvance(TAP_MS * 1000UL);
+  simSetPin(P1_BUTTON, LOW); // dropped, the ring is still full
+  run(BUTTON_HOLD_MS + 1000);
+  p1_score++;
+  check(shownScore(0) == p1_score && shownScore(1) == 1,
+        "full edge ring still reports the release (no phantom hold)");
+#endif
+
+#ifdef STATS_SERIAL
+  // STATS DUMP ON REQUEST (before any reboot clears the histograms)
+  char cmd[] = { STATS_DUMP_CMD, 0 };
+  simSerialInput(cmd);
+  run(1);
+#endif
+
+#ifdef RESUME_GAME
+  // RESET MID-GAME (RAM survives, globals are set up again)
+  boot();
+  run(10);
+  check(shownScore(0) == p1_score && shownScore(1) == 1, "reset mid-game resumes the score");
+
+  // RESET AT 21-20 (restoring 21 before 20 must not win)
+  for(int i = 0; i < 19; i++) press(P2_BUTTON, TAP_MS);
+  for(int i = p1_score; i < 21; i++) press(P1_BUTTON, TAP_MS);
+  boot();
+  run(10);
+  check(!winner_found && games_played == 0 && shownScore(0) == 21 && shownScore(1) == 20,
+        "reset at 21-20 resumes with no winner");
+
+#ifndef SCORE_JOURNAL
+  saved_game.score[1] ^= 0x10;
+  boot();
+  run(10);
+  check(shownScore(0) == 0 && shownScore(1) == 0, "corrupt saved game starts at 00 00");
+#endif
+#endif
+
+#ifdef SCORE_JOURNAL
+  // POWER CUT MID-GAME REPLAYS THE EEPROM JOURNAL
+  powerCycle();
+  run(10);
+  check(shownScore(0) == 21 && shownScore(1) == 20, "power cut replays the journal: 21 20");
+
+  press(P1_BUTTON, BUTTON_HOLD_MS + 100);
+  powerCycle();
+  run(10);
+  check(shownScore(0) == 0 && shownScore(1) == 0, "journaled reset replays as 00 00");
+#endif
+
+#ifdef RULES_FROM_EEPROM
+  // RULESET PICKED FROM EEPROM AT BOOT
+  simEepromWrite(RULES_EEPROM_ADDR, RULES_PICKLEBALL);
+  boot();
+  for(int i = 0; i < 9; i++) press(P2_BUTTON, TAP_MS);
+  for(int i = 0; i < 10; i++) press(P1_BUTTON, TAP_MS);
+  check(!winner_found, "EEPROM ruleset: no winner at 10-9");
+  press(P1_BUTTON, TAP_MS);
+  check(winner_found && winner == 0, "EEPROM ruleset: player 1 wins at 11-9");
+
+  // BEST OF 3: STANDINGS, THEN NEXT GAME IN PLACE
+  run(GAME_OVER_MS);
+  check(shownStandings(0) == 1 && shownStandings(1) == 0, "match shows games won 1 0");
+  run(STANDINGS_MS);
+  check(!winner_found && reboots == 0 && shownScore(0) == 0 && shownScore(1) == 0,
+        "next game starts at 00 00 without a reset");
+  check(games_played == 1 && game_history[0].score[0] == 11 &&
+        game_history[0].score[1] == 9, "game 1 recorded as 11-9");
+
+  for(int i = 0; i < 11; i++) press(P1_BUTTON, TAP_MS);
+  run(GAME_OVER_MS + STANDINGS_MS);
+  check(winner_found && match_over && winner == 0 && games_won[0] == 2 &&
+        shownScore(1) == 0, "player 1 wins the match 2-0 and it stays over");
+
+#ifdef SCORE_JOURNAL
+  powerCycle();
+  run(10);
+  check(match_over && games_played == 2 && games_won[0] == 2 &&
+        game_history[1].score[0] == 11, "power cut replays the match from the journal");
+#endif
+#endif
+
+#ifdef WATCHDOG_RESET
+  // LONG HOLD REBOOTS THROUGH THE WATCHDOG
+  press(P1_BUTTON, HARD_RESET_HOLD_MS + 100);
+  check(reboots == 1 && !(MCUSR & _BV(WDRF)), "10 s hold reboots the board");
+  check(shownScore(0) == 0 && shownScore(1) == 0, "reboot shows 00 00");
+#endif
+
+#ifdef SCORE_JOURNAL
+  // TORN JOURNAL WRITE ON AN ODD PASS (reads back erased with the lap bit)
+  for(uint16_t i = 0; i < JOURNAL_SLOTS; i++) {
+    simEepromWrite(JOURNAL_EEPROM_START + i, JOURNAL_RESET); // last pass
+  }
+  powerCycle();
+  press(P1_BUTTON, TAP_MS);
+  press(P2_BUTTON, TAP_MS);
+  simEepromWrite(JOURNAL_EEPROM_START + 1, 0xFF); // P2's point torn
+  press(P1_BUTTON, TAP_MS);
+  powerCycle();
+  run(10);
+  check(shownScore(0) == 2 && shownScore(1) == 0,
+        "torn journal record skipped, the points around it replay: 02 00");
+#endif
+
+  // DELAY SKIPS VIRTUAL TIME, NO WALL CLOCK WAIT
+  struct timespec wall_start, wall_end;
+  clock_gettime(CLOCK_MONOTONIC, &wall_start);
+  unsigned long before = millis();
+  delay(20UL * 60 * 1000);
+  clock_gettime(CLOCK_MONOTONIC, &wall_end);
+  check(millis() - before == 20UL * 60 * 1000 && wall_end.tv_sec - wall_start.tv_sec < 2,
+        "20 min delay() passes at once on the virtual clock");
+
+  printf("%s: %d failure(s), %.1f s simulated\n", failures ? "FAILED" : "OK",
+         failures, elapsed_us / 1e6);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+/*===================================================================*\   
+|                              META DATA                              |
+\*===================================================================*/
+
+// Filename------------+ util/crc16.h
+// Description---------+ Host stand-in for avr-libc's CRC routines, same
+// --------------------- polynomials and bit order
+
+#ifndef SIM_UTIL_CRC16_H
+#define SIM_UTIL_CRC16_H
+
+#include <stdint.h>
+
+/*===================================================================*\   
+|                              FUNCTIONS                              |
+\*===================================================================*/
+
+/*
+ * @brief CRC-16 (x^16 + x^15 + x^2 + 1, reflected 0xA001) of one byte
+*/
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t data) {
+  crc ^= data;
+  for(uint8_t i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  return crc;
+}
+
+#endif